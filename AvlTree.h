@@ -1,11 +1,28 @@
 #pragma once
 
-template <typename KeyType, typename ValueType>
+#include <type_traits>
+#include <utility>
+
+#include "ForkJoin.h"
+#include "NodePool.h"
+
+// The audit policy of an AvlTree: Audit::check(tree, event, node) runs after
+// every rotation, rebalance and node swap, and Audit is a friend of the tree
+// and its nodes so it can read their internals. The default does nothing;
+// a test harness passes its own (see tools/AvlTreeStress.cpp), which makes
+// the audited tree a type of its own.
+struct AvlTreeNoAudit {
+    template <typename Tree, typename Node>
+    static void check(const Tree&, const char*, const Node*) {}
+};
+
+template <typename KeyType, typename ValueType, typename Audit = AvlTreeNoAudit>
 class AvlTree;
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Audit = AvlTreeNoAudit>
 class TreeNode {
-    friend class AvlTree<KeyType, ValueType>;
+    friend class AvlTree<KeyType, ValueType, Audit>;
+    friend Audit;
     KeyType key;
     ValueType value;
     TreeNode* parent = nullptr;
@@ -14,7 +31,7 @@ class TreeNode {
     int height = 0; // to calc balance factor, correct to hold here?
     // need to add height to all functions
     TreeNode(KeyType k, ValueType v, TreeNode* p = nullptr)
-        : key(k), value(v), parent(p) {}
+        : key(k), value(std::move(v)), parent(p) {}
 
 public:
 
@@ -31,11 +48,31 @@ void swapFields(T &f1, T &f2)
     f2 = temp;
 }
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Audit>
 class AvlTree {
-    using Node = TreeNode<KeyType,ValueType>;
+    friend Audit;
+    using Node = TreeNode<KeyType,ValueType,Audit>;
 
     Node* root = nullptr;
+    NodePool<Node> pool;
+
+    // constructs a node in storage from the pool
+    Node* createNode(const KeyType& key, const ValueType& value,
+                     Node* parent = nullptr) {
+        void* storage = pool.allocate();
+        try {
+            return new (storage) Node{key, value, parent};
+        }
+        catch (...) {
+            pool.deallocate(storage);
+            throw;
+        }
+    }
+
+    void deleteNode(Node* node) {
+        node->~Node();
+        pool.deallocate(node);
+    }
 
     static bool nodeIsRightSon(Node* node)
     {
@@ -185,13 +222,127 @@ class AvlTree {
         return getHeight(node->left) - getHeight(node->right);
     }
 
+    // runs the destructors of a subtree, its storage stays with the pool.
+    // there is nothing to run, and so no walk, for trivial keys and values
     void destruct(Node* currentRoot) {
-        if (currentRoot == nullptr) {
+        if (currentRoot == nullptr ||
+            std::is_trivially_destructible<Node>::value) {
             return;
         }
         destruct(currentRoot->left); // destruct left subtree
         destruct(currentRoot->right); // destruct right subtree
-        delete currentRoot;
+        currentRoot->~Node();
+    }
+
+    // subtrees below these sizes are not worth a thread of their own
+    static const int PARALLEL_BUILD_MIN = 1 << 14;
+    static const int PARALLEL_DESTRUCT_MIN_HEIGHT = 14;
+
+    void destruct(Node* currentRoot, int threads) {
+        if (currentRoot == nullptr ||
+            std::is_trivially_destructible<Node>::value) {
+            return;
+        }
+        if (threads < 2 || currentRoot->height < PARALLEL_DESTRUCT_MIN_HEIGHT) {
+            destruct(currentRoot);
+            return;
+        }
+        // the two subtrees are disjoint, so they can be freed concurrently
+        auto destructLeft = [this, currentRoot, threads]() {
+            destruct(currentRoot->left, threads / 2);
+        };
+        auto destructRight = [this, currentRoot, threads]() {
+            destruct(currentRoot->right, threads - threads / 2);
+        };
+        forkJoin(destructLeft, destructRight);
+        currentRoot->~Node();
+    }
+
+    // builds a perfectly balanced subtree of the elements [low, high), element
+    // i is placed in slot i of block so threads never share the pool
+    template <typename KeyAt, typename ValueAt>
+    Node* build(const KeyAt& keyAt, const ValueAt& valueAt, int low, int high,
+                Node* parent, void* block, int threads) {
+        if (low >= high) {
+            return nullptr;
+        }
+        const int mid = low + (high - low) / 2;
+        Node* node = new (NodePool<Node>::slotOf(block, mid))
+            Node{keyAt(mid), valueAt(mid), parent};
+        try {
+            if (threads > 1 && high - low >= PARALLEL_BUILD_MIN) {
+                auto buildLeft = [&]() {
+                    node->left = build(keyAt, valueAt, low, mid, node, block,
+                                       threads / 2);
+                };
+                auto buildRight = [&]() {
+                    node->right = build(keyAt, valueAt, mid + 1, high, node,
+                                        block, threads - threads / 2);
+                };
+                forkJoin(buildLeft, buildRight);
+            }
+            else {
+                node->left = build(keyAt, valueAt, low, mid, node, block, 1);
+                node->right = build(keyAt, valueAt, mid + 1, high, node, block,
+                                    1);
+            }
+        }
+        catch (...) {
+            destruct(node->left);
+            destruct(node->right);
+            node->~Node();
+            throw;
+        }
+        updateNodeHeight(node);
+        return node;
+    }
+
+    // deep copy of a subtree, on failure everything copied so far is freed
+    Node* clone(const Node* source, Node* parent) {
+        if (source == nullptr) {
+            return nullptr;
+        }
+        Node* node = createNode(source->key, source->value, parent);
+        try {
+            node->left = clone(source->left, node);
+            node->right = clone(source->right, node);
+        }
+        catch (...) {
+            destruct(node->left);
+            destruct(node->right);
+            node->~Node();
+            throw;
+        }
+        node->height = source->height;
+        return node;
+    }
+
+    // moves a subtree into consecutive slots of block in preorder, so that
+    // a parent sits right before its left subtree
+    static Node* relocate(Node* node, Node* parent, void* block,
+                          std::size_t& next) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        Node* moved = new (NodePool<Node>::slotOf(block, next++))
+            Node(std::move(*node));
+        Node* left = node->left;
+        Node* right = node->right;
+        node->~Node();
+        moved->parent = parent;
+        moved->left = relocate(left, moved, block, next);
+        moved->right = relocate(right, moved, block, next);
+        return moved;
+    }
+
+    template <typename Function>
+    static void inorder(Node* node, Function& function) {
+        if (node == nullptr) {
+            return;
+        }
+        inorder(node->left, function);
+        function(node->key, node->value);
+        inorder(node->right, function);
     }
 
     bool rollHelper(Node* p) {
@@ -216,6 +367,7 @@ class AvlTree {
             }
             else { rollRR(p); }
         }
+        Audit::check(*this, "rebalance", p->parent);
         return true;
     }
 
@@ -279,6 +431,7 @@ class AvlTree {
         // update height of B before that of A, because B is now son of A
         updateNodeHeight(B);
         updateNodeHeight(A);
+        Audit::check(*this, "rollRR", A);
     }
 
     void rollRL(Node* C) {
@@ -316,6 +469,7 @@ class AvlTree {
         // update height of B before that of A, because B is now son of A
         updateNodeHeight(B);
         updateNodeHeight(A);
+        Audit::check(*this, "rollLL", A);
     }
 
     void rollLR(Node* C) {
@@ -327,6 +481,20 @@ class AvlTree {
 
 public:
 
+    AvlTree() = default;
+
+    // deep copy. may throw bad_alloc
+    AvlTree(const AvlTree& other) {
+        root = clone(other.root, nullptr);
+    }
+
+    AvlTree(AvlTree&& other) noexcept : root(other.root) {
+        pool.swap(other.pool);
+        other.root = nullptr;
+    }
+
+    AvlTree& operator=(const AvlTree&) = delete;
+
     ~AvlTree() {
         // need to traverse in postorder and destroy each node
         destruct(root);
@@ -360,7 +528,7 @@ public:
 
         if (root == nullptr) {
             // tree is empty, create new node and set it as root
-            root = new Node{key, value};
+            root = createNode(key, value);
             return true;
         }
 
@@ -383,7 +551,7 @@ public:
                 current = current->right;
             }
         }
-        Node* newNode = new Node{key, value, parent};
+        Node* newNode = createNode(key, value, parent);
 
         if (key < parent->key) {
             parent->left = newNode;
@@ -444,13 +612,14 @@ public:
 
             Node* successor = findSuccessor(toDelete);
             swap(toDelete, successor);
+            Audit::check(*this, "swap", successor);
             erase(toDelete); // is always either leaf, or has only right son
             // if it had left son, it would have been the successor
             return true; // because we swapped by value
         }
 
         eraseReBalance(toDelete -> parent);
-        delete toDelete;
+        deleteNode(toDelete);
         return true;
     }
 
@@ -465,5 +634,98 @@ public:
         return root == nullptr;
     }
 
+    // fills an empty tree with count elements whose keys keyAt(0..count)
+    // are strictly increasing. disjoint subtrees are built on up to threads
+    // threads. may throw bad_alloc, in which case the tree stays empty
+    template <typename KeyAt, typename ValueAt>
+    void assignSorted(int count, const KeyAt& keyAt, const ValueAt& valueAt,
+                      int threads = 1)
+    {
+        if (count <= 0) {
+            return;
+        }
+        // the whole tree goes into one block, laid out in key order
+        pool.releaseAll();
+        void* block = pool.allocateBlock(count);
+        try {
+            root = build(keyAt, valueAt, 0, count, nullptr, block, threads);
+        }
+        catch (...) {
+            pool.releaseAll();
+            throw;
+        }
+    }
+
+    // frees all nodes. values with destructors of their own are destroyed
+    // on up to threads threads, a disjoint subtree each
+    void clear(int threads = 1)
+    {
+        destruct(root, threads);
+        root = nullptr;
+        pool.releaseAll();
+    }
+
+    int size() const
+    {
+        return static_cast<int>(pool.size());
+    }
+
+    TreeMemory memoryUsage() const
+    {
+        return pool.memoryUsage();
+    }
+
+    // moves all nodes into a single block of exactly size() nodes and gives
+    // the old chunks back to the heap. node handles from before are invalid
+    // afterwards. may throw bad_alloc, in which case the tree is unchanged
+    void compact()
+    {
+        setPlacement(pool.getPlacement());
+    }
+
+    // like compact(), but the block and every node allocated from now on
+    // come from memory placed as asked
+    void setPlacement(const MemoryPlacement& placement)
+    {
+        NodePool<Node> dense(placement);
+        if (root != nullptr) {
+            void* block = dense.allocateBlock(pool.size());
+            std::size_t next = 0;
+            root = relocate(root, nullptr, block, next);
+        }
+        pool.swap(dense);
+    }
+
+    // calls function(value) for every element in key order
+    template <typename Function>
+    void forEachValue(Function function)
+    {
+        auto valueFunction = [&function](const KeyType&, ValueType& value) {
+            function(value);
+        };
+        inorder(root, valueFunction);
+    }
+
+    template <typename Function>
+    void forEachValue(Function function) const
+    {
+        auto constFunction = [&function](const KeyType&,
+                                         const ValueType& value) {
+            function(value);
+        };
+        inorder(root, constFunction);
+    }
+
+    // calls function(key, value) for every element in key order
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        auto constFunction = [&function](const KeyType& key,
+                                         const ValueType& value) {
+            function(key, value);
+        };
+        inorder(root, constFunction);
+    }
+
 
 };
@@ -0,0 +1,780 @@
+#pragma once
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "ForkJoin.h"
+#include "NodePool.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// B+-tree with the same find/insert/erase(handle) surface as AvlTree.
+// Nodes hold one cache line of keys, aligned to a line of its own, so a
+// lookup touches ~log16(n) lines instead of ~1.44*log2(n) tree nodes.
+// Entries live inline in the leaves, right after their keys, so a lookup
+// ends at the leaf instead of chasing one more pointer. They move on splits,
+// merges and shifts: a handle from find(), like any pointer into its value,
+// is only good until the next insert or erase.
+
+struct BTreeAudit;
+
+template <typename KeyType, typename ValueType>
+class BTree;
+
+template <typename KeyType, typename ValueType>
+class BTreeEntry {
+    friend class BTree<KeyType, ValueType>;
+    friend struct BTreeAudit;
+    KeyType key;
+    ValueType value;
+
+    BTreeEntry(const KeyType& k, const ValueType& v) : key(k), value(v) {}
+
+public:
+
+    ValueType& getValue() {
+        return value;
+    }
+
+};
+
+template <typename KeyType, int Capacity>
+struct BTreeKeySearch {
+    // number of keys in the sorted prefix keys[0..count) that are <= key
+    static int upperBound(const KeyType* keys, int count, const KeyType& key) {
+        int low = 0;
+        int high = count;
+        while (low < high) {
+            const int mid = (low + high) / 2;
+            if (key < keys[mid]) {
+                high = mid;
+            }
+            else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    }
+};
+
+#ifdef __SSE2__
+template <int Capacity>
+struct BTreeKeySearch<int, Capacity> {
+    static_assert(Capacity % 4 == 0 && Capacity <= 32,
+                  "int key block must be whole SSE registers");
+
+    // compares the whole key block at once, slots past count are masked
+    // out. keys must be 16 byte aligned, as node key blocks are
+    static int upperBound(const int* keys, int count, int key) {
+        const __m128i needle = _mm_set1_epi32(key);
+        unsigned int greater = 0;
+        for (int i = 0; i < Capacity; i += 4) {
+            const __m128i block =
+                _mm_load_si128(reinterpret_cast<const __m128i*>(keys + i));
+            const int mask = _mm_movemask_ps(
+                _mm_castsi128_ps(_mm_cmpgt_epi32(block, needle)));
+            greater |= static_cast<unsigned int>(mask) << i;
+        }
+        greater &= (count >= 32) ? ~0u : ((1u << count) - 1);
+        return count - __builtin_popcount(greater);
+    }
+};
+#endif
+
+template <typename KeyType, typename ValueType>
+class BTree {
+    friend struct BTreeAudit;
+
+public:
+    using Entry = BTreeEntry<KeyType, ValueType>;
+
+private:
+    static_assert(std::is_nothrow_move_constructible<ValueType>::value,
+                  "entries move between leaves, which must not throw");
+
+    static const int LINE = 64;
+    // keys of a node fill one cache line
+    static const int CAPACITY =
+        LINE / sizeof(KeyType) >= 4 ? static_cast<int>(LINE / sizeof(KeyType)) : 4;
+    static const int MIN_KEYS = CAPACITY / 2;
+    // enough for any tree that fits in memory (fanout >= MIN_KEYS + 1)
+    static const int MAX_DEPTH = 64;
+    // leaves holding fewer elements than this between them are not worth a
+    // thread of their own
+    static const int PARALLEL_BUILD_MIN = 1 << 14;
+
+    using Search = BTreeKeySearch<KeyType, CAPACITY>;
+
+    struct alignas(LINE) Node {
+        KeyType keys[CAPACITY] = {}; // first, so they start the aligned line
+        int count = 0;
+        bool isLeaf;
+
+        explicit Node(bool leaf) : isLeaf(leaf) {}
+    };
+
+    struct Leaf : Node {
+        // entries()[0..count) are constructed, the rest is raw storage
+        alignas(Entry) unsigned char storage[CAPACITY * sizeof(Entry)];
+
+        Leaf() : Node(true) {}
+
+        Entry* entries() {
+            return reinterpret_cast<Entry*>(storage);
+        }
+    };
+
+    struct Inner : Node {
+        // children[i] holds keys in [keys[i-1], keys[i])
+        Node* children[CAPACITY + 1] = {};
+
+        Inner() : Node(false) {}
+    };
+
+    Node* root = nullptr;
+    // node pools hand out cache line aligned storage, which the SIMD key
+    // search relies on
+    NodePool<Leaf> leaves;
+    NodePool<Inner> inners;
+
+    static Leaf* asLeaf(Node* node) {
+        return static_cast<Leaf*>(node);
+    }
+
+    static Inner* asInner(Node* node) {
+        return static_cast<Inner*>(node);
+    }
+
+    Leaf* newLeaf() {
+        return new (leaves.allocate()) Leaf();
+    }
+
+    Inner* newInner() {
+        return new (inners.allocate()) Inner();
+    }
+
+    // the entries of a leaf must already be gone
+    void deleteNode(Node* node) {
+        if (node->isLeaf) {
+            asLeaf(node)->~Leaf();
+            leaves.deallocate(node);
+        }
+        else {
+            asInner(node)->~Inner();
+            inners.deallocate(node);
+        }
+    }
+
+    // moves the entry at from into the raw slot at to, leaving from raw
+    static void moveEntry(Entry* to, Entry* from) {
+        new (to) Entry(std::move(*from));
+        from->~Entry();
+    }
+
+    // descends to the leaf that should hold key, recording the inner nodes
+    // visited and the child index taken in each of them
+    Leaf* descend(const KeyType& key, Inner** path, int* childIndex,
+                  int& depth) const {
+        depth = 0;
+        Node* current = root;
+        while (!current->isLeaf) {
+            Inner* inner = asInner(current);
+            const int index = Search::upperBound(inner->keys, inner->count, key);
+            path[depth] = inner;
+            childIndex[depth] = index;
+            depth++;
+            current = inner->children[index];
+        }
+        return asLeaf(current);
+    }
+
+    // first of the count elements that go to part index when they are
+    // split as evenly as possible into parts parts
+    static int partStart(const int index, const int count, const int parts) {
+        return static_cast<int>(static_cast<long long>(index) * count / parts);
+    }
+
+    static const KeyType& lowestKey(Node* node) {
+        while (!node->isLeaf) {
+            node = asInner(node)->children[0];
+        }
+        return node->keys[0];
+    }
+
+    // builds the inner levels over the count leaves at consecutive slots of
+    // leafBlock, bottom up, each parent taking as even a share of the level
+    // below as the count allows, and returns the root. may throw bad_alloc,
+    // leaving the nodes built so far to the pools
+    Node* buildInnerLevels(void* leafBlock, int count) {
+        // the level being covered sits at consecutive slots of block
+        void* block = leafBlock;
+        bool leafLevel = true;
+        auto nodeAt = [&block, &leafLevel](const int i) -> Node* {
+            if (leafLevel) {
+                return static_cast<Leaf*>(NodePool<Leaf>::slotOf(block, i));
+            }
+            return static_cast<Inner*>(NodePool<Inner>::slotOf(block, i));
+        };
+        while (count > 1) {
+            const int parents = (count + CAPACITY) / (CAPACITY + 1);
+            void* parentBlock = inners.allocateBlock(parents);
+            for (int i = 0; i < parents; i++) {
+                Inner* parent = new (NodePool<Inner>::slotOf(parentBlock, i))
+                    Inner();
+                const int first = partStart(i, count, parents);
+                const int last = partStart(i + 1, count, parents);
+                for (int child = first; child < last; child++) {
+                    Node* node = nodeAt(child);
+                    if (child > first) {
+                        parent->keys[child - first - 1] = lowestKey(node);
+                    }
+                    parent->children[child - first] = node;
+                }
+                parent->count = last - first - 1;
+            }
+            block = parentBlock;
+            leafLevel = false;
+            count = parents;
+        }
+        return nodeAt(0);
+    }
+
+    // runs the destructors of the entries of a subtree, the nodes themselves
+    // stay with the pools
+    static void destruct(Node* node) {
+        if (node == nullptr || std::is_trivially_destructible<Entry>::value) {
+            return;
+        }
+        if (node->isLeaf) {
+            Leaf* leaf = asLeaf(node);
+            for (int i = 0; i < leaf->count; i++) {
+                leaf->entries()[i].~Entry();
+            }
+            return;
+        }
+        Inner* inner = asInner(node);
+        for (int i = 0; i <= inner->count; i++) {
+            destruct(inner->children[i]);
+        }
+    }
+
+    template <typename Function>
+    static void inorder(Node* node, Function& function) {
+        if (node->isLeaf) {
+            Leaf* leaf = asLeaf(node);
+            for (int i = 0; i < leaf->count; i++) {
+                function(leaf->keys[i], leaf->entries()[i].value);
+            }
+            return;
+        }
+        Inner* inner = asInner(node);
+        for (int i = 0; i <= inner->count; i++) {
+            inorder(inner->children[i], function);
+        }
+    }
+
+    // entry must be constructed, slot pos and up are shifted to make room
+    static void leafInsertAt(Leaf* leaf, int pos, const KeyType& key,
+                             Entry&& entry) {
+        Entry* entries = leaf->entries();
+        for (int i = leaf->count; i > pos; i--) {
+            leaf->keys[i] = leaf->keys[i - 1];
+            moveEntry(&entries[i], &entries[i - 1]);
+        }
+        leaf->keys[pos] = key;
+        new (&entries[pos]) Entry(std::move(entry));
+        leaf->count++;
+    }
+
+    // the entry at pos must already be destroyed or moved out
+    static void leafCloseGap(Leaf* leaf, int pos) {
+        Entry* entries = leaf->entries();
+        for (int i = pos; i < leaf->count - 1; i++) {
+            leaf->keys[i] = leaf->keys[i + 1];
+            moveEntry(&entries[i], &entries[i + 1]);
+        }
+        leaf->count--;
+    }
+
+    // inserts key at pos and its right child at pos + 1
+    static void innerInsertAt(Inner* inner, int pos, const KeyType& key,
+                              Node* rightChild) {
+        for (int i = inner->count; i > pos; i--) {
+            inner->keys[i] = inner->keys[i - 1];
+            inner->children[i + 1] = inner->children[i];
+        }
+        inner->keys[pos] = key;
+        inner->children[pos + 1] = rightChild;
+        inner->count++;
+    }
+
+    // removes key at pos and its right child at pos + 1
+    static void innerRemoveAt(Inner* inner, int pos) {
+        for (int i = pos; i < inner->count - 1; i++) {
+            inner->keys[i] = inner->keys[i + 1];
+            inner->children[i + 1] = inner->children[i + 2];
+        }
+        inner->count--;
+    }
+
+    // splits a full leaf while inserting (key, entry) at pos. the upper half
+    // moves to the empty sibling, and the first key of sibling is returned
+    // as separator. the halves are cut so the new entry lands in the right
+    // one and the left keeps (CAPACITY + 1) / 2 entries either way
+    static KeyType splitLeaf(Leaf* leaf, Leaf* sibling, int pos,
+                             const KeyType& key, Entry&& entry) {
+        const int leftCount = (CAPACITY + 1) / 2;
+        const int cut = pos < leftCount ? leftCount - 1 : leftCount;
+        for (int i = cut; i < CAPACITY; i++) {
+            sibling->keys[i - cut] = leaf->keys[i];
+            moveEntry(&sibling->entries()[i - cut], &leaf->entries()[i]);
+        }
+        sibling->count = CAPACITY - cut;
+        leaf->count = cut;
+        if (pos < leftCount) {
+            leafInsertAt(leaf, pos, key, std::move(entry));
+        }
+        else {
+            leafInsertAt(sibling, pos - cut, key, std::move(entry));
+        }
+        return sibling->keys[0];
+    }
+
+    // splits a full inner node while inserting (key, rightChild) at pos.
+    // the middle key moves up and is returned
+    static KeyType splitInner(Inner* inner, Inner* sibling, int pos,
+                              const KeyType& key, Node* rightChild) {
+        KeyType keys[CAPACITY + 1];
+        Node* children[CAPACITY + 2];
+        children[0] = inner->children[0];
+        for (int i = 0, j = 0; i <= CAPACITY; i++) {
+            if (i == pos) {
+                keys[i] = key;
+                children[i + 1] = rightChild;
+            }
+            else {
+                keys[i] = inner->keys[j];
+                children[i + 1] = inner->children[j + 1];
+                j++;
+            }
+        }
+        const int leftCount = CAPACITY / 2;
+        for (int i = 0; i < leftCount; i++) {
+            inner->keys[i] = keys[i];
+            inner->children[i + 1] = children[i + 1];
+        }
+        inner->count = leftCount;
+        const int rightCount = CAPACITY - leftCount;
+        sibling->children[0] = children[leftCount + 1];
+        for (int i = 0; i < rightCount; i++) {
+            sibling->keys[i] = keys[leftCount + 1 + i];
+            sibling->children[i + 1] = children[leftCount + 2 + i];
+        }
+        sibling->count = rightCount;
+        return keys[leftCount];
+    }
+
+    // node at path[level]'s child index has underflowed - borrow from or
+    // merge with a sibling, walking up while parents underflow in turn
+    void fixUnderflow(Node* node, Inner** path, int* childIndex, int level) {
+        while (level > 0 && node->count < MIN_KEYS) {
+            Inner* parent = path[level - 1];
+            const int index = childIndex[level - 1];
+            Node* left = index > 0 ? parent->children[index - 1] : nullptr;
+            Node* right = index < parent->count ? parent->children[index + 1]
+                                                : nullptr;
+
+            if (left && left->count > MIN_KEYS) {
+                borrowFromLeft(node, left, parent, index);
+                return;
+            }
+            if (right && right->count > MIN_KEYS) {
+                borrowFromRight(node, right, parent, index);
+                return;
+            }
+            if (left) {
+                merge(left, node, parent, index - 1);
+            }
+            else {
+                merge(node, right, parent, index);
+            }
+            node = parent;
+            level--;
+        }
+
+        if (!root->isLeaf && root->count == 0) {
+            // the root lost its last separator, its only child replaces it
+            Node* oldRoot = root;
+            root = asInner(oldRoot)->children[0];
+            deleteNode(oldRoot);
+        }
+    }
+
+    static void borrowFromLeft(Node* node, Node* left, Inner* parent,
+                               int index) {
+        if (node->isLeaf) {
+            Leaf* leaf = asLeaf(node);
+            Leaf* donor = asLeaf(left);
+            Entry* last = &donor->entries()[donor->count - 1];
+            leafInsertAt(leaf, 0, donor->keys[donor->count - 1],
+                         std::move(*last));
+            last->~Entry();
+            donor->count--;
+            parent->keys[index - 1] = leaf->keys[0];
+            return;
+        }
+        Inner* inner = asInner(node);
+        Inner* donor = asInner(left);
+        for (int i = inner->count; i > 0; i--) {
+            inner->keys[i] = inner->keys[i - 1];
+        }
+        for (int i = inner->count + 1; i > 0; i--) {
+            inner->children[i] = inner->children[i - 1];
+        }
+        inner->keys[0] = parent->keys[index - 1];
+        inner->children[0] = donor->children[donor->count];
+        inner->count++;
+        parent->keys[index - 1] = donor->keys[donor->count - 1];
+        donor->count--;
+    }
+
+    static void borrowFromRight(Node* node, Node* right, Inner* parent,
+                                int index) {
+        if (node->isLeaf) {
+            Leaf* leaf = asLeaf(node);
+            Leaf* donor = asLeaf(right);
+            leaf->keys[leaf->count] = donor->keys[0];
+            moveEntry(&leaf->entries()[leaf->count], &donor->entries()[0]);
+            leaf->count++;
+            leafCloseGap(donor, 0);
+            parent->keys[index] = donor->keys[0];
+            return;
+        }
+        Inner* inner = asInner(node);
+        Inner* donor = asInner(right);
+        inner->keys[inner->count] = parent->keys[index];
+        inner->children[inner->count + 1] = donor->children[0];
+        inner->count++;
+        parent->keys[index] = donor->keys[0];
+        for (int i = 0; i < donor->count - 1; i++) {
+            donor->keys[i] = donor->keys[i + 1];
+        }
+        for (int i = 0; i < donor->count; i++) {
+            donor->children[i] = donor->children[i + 1];
+        }
+        donor->count--;
+    }
+
+    // moves everything from right into left and drops the separator at
+    // parent->keys[separator] together with right
+    void merge(Node* left, Node* right, Inner* parent, int separator) {
+        if (left->isLeaf) {
+            Leaf* to = asLeaf(left);
+            Leaf* from = asLeaf(right);
+            for (int i = 0; i < from->count; i++) {
+                to->keys[to->count + i] = from->keys[i];
+                moveEntry(&to->entries()[to->count + i], &from->entries()[i]);
+            }
+            to->count += from->count;
+        }
+        else {
+            Inner* to = asInner(left);
+            Inner* from = asInner(right);
+            to->keys[to->count] = parent->keys[separator];
+            to->children[to->count + 1] = from->children[0];
+            for (int i = 0; i < from->count; i++) {
+                to->keys[to->count + 1 + i] = from->keys[i];
+                to->children[to->count + 2 + i] = from->children[i + 1];
+            }
+            to->count += from->count + 1;
+        }
+        deleteNode(right);
+        innerRemoveAt(parent, separator);
+    }
+
+public:
+
+    BTree() = default;
+
+    BTree(const BTree&) = delete;
+
+    BTree& operator=(const BTree&) = delete;
+
+    ~BTree() {
+        destruct(root);
+    }
+
+    Entry* find(const KeyType& key) const
+    {
+        if (root == nullptr) {
+            return nullptr;
+        }
+        Node* current = root;
+        while (!current->isLeaf) {
+            Inner* inner = asInner(current);
+            current = inner->children[
+                Search::upperBound(inner->keys, inner->count, key)];
+        }
+        Leaf* leaf = asLeaf(current);
+        const int pos = Search::upperBound(leaf->keys, leaf->count, key);
+        if (pos > 0 && leaf->keys[pos - 1] == key) {
+            return &leaf->entries()[pos - 1];
+        }
+        return nullptr;
+    }
+
+    bool insert(const KeyType& key, const ValueType& value) // false if key already in tree
+    {
+        if (root == nullptr) {
+            Leaf* leaf = newLeaf();
+            try {
+                new (leaf->entries()) Entry(key, value);
+            }
+            catch (...) {
+                deleteNode(leaf);
+                throw;
+            }
+            leaf->keys[0] = key;
+            leaf->count = 1;
+            root = leaf;
+            return true;
+        }
+
+        Inner* path[MAX_DEPTH];
+        int childIndex[MAX_DEPTH];
+        int depth = 0;
+        Leaf* leaf = descend(key, path, childIndex, depth);
+        const int pos = Search::upperBound(leaf->keys, leaf->count, key);
+        if (pos > 0 && leaf->keys[pos - 1] == key) {
+            return false;
+        }
+
+        // copy the value and allocate every node the insert can need before
+        // touching the tree, so a bad_alloc leaves it unchanged
+        Entry entry(key, value);
+        int splits = 0;
+        if (leaf->count == CAPACITY) {
+            splits = 1;
+            while (splits <= depth && path[depth - splits]->count == CAPACITY) {
+                splits++;
+            }
+        }
+        const bool growsRoot = splits > depth;
+        Leaf* splitOff = nullptr;
+        Inner* newInners[MAX_DEPTH + 1] = {};
+        const int innerCount = splits == 0 ? 0 : splits - 1 + (growsRoot ? 1 : 0);
+        int allocated = 0;
+        try {
+            if (splits > 0) {
+                splitOff = newLeaf();
+            }
+            for (; allocated < innerCount; allocated++) {
+                newInners[allocated] = newInner();
+            }
+        }
+        catch (...) {
+            if (splitOff != nullptr) {
+                deleteNode(splitOff);
+            }
+            for (int i = 0; i < allocated; i++) {
+                deleteNode(newInners[i]);
+            }
+            throw;
+        }
+
+        if (splits == 0) {
+            leafInsertAt(leaf, pos, key, std::move(entry));
+            return true;
+        }
+
+        KeyType separator = splitLeaf(leaf, splitOff, pos, key, std::move(entry));
+        Node* rightChild = splitOff;
+        int used = 0;
+        for (int level = depth - 1; level >= 0; level--) {
+            Inner* parent = path[level];
+            const int index = childIndex[level];
+            if (parent->count < CAPACITY) {
+                innerInsertAt(parent, index, separator, rightChild);
+                return true;
+            }
+            Inner* sibling = newInners[used++];
+            separator = splitInner(parent, sibling, index, separator, rightChild);
+            rightChild = sibling;
+        }
+
+        // the split reached the root
+        Inner* newRoot = newInners[used];
+        newRoot->keys[0] = separator;
+        newRoot->children[0] = root;
+        newRoot->children[1] = rightChild;
+        newRoot->count = 1;
+        root = newRoot;
+        return true;
+    }
+
+    bool erase(Entry* toDelete) {
+        if (toDelete == nullptr) {
+            // key not in tree
+            return false;
+        }
+        const KeyType key = toDelete->key;
+        return erase(key);
+    }
+
+    bool erase(const KeyType& key) // false if doesnt exist
+    {
+        if (root == nullptr) {
+            return false;
+        }
+        Inner* path[MAX_DEPTH];
+        int childIndex[MAX_DEPTH];
+        int depth = 0;
+        Leaf* leaf = descend(key, path, childIndex, depth);
+        const int pos = Search::upperBound(leaf->keys, leaf->count, key);
+        if (pos == 0 || !(leaf->keys[pos - 1] == key)) {
+            return false;
+        }
+
+        leaf->entries()[pos - 1].~Entry();
+        leafCloseGap(leaf, pos - 1);
+
+        if (leaf == root) {
+            if (leaf->count == 0) {
+                deleteNode(leaf);
+                root = nullptr;
+            }
+            return true;
+        }
+        fixUnderflow(leaf, path, childIndex, depth);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return root == nullptr;
+    }
+
+    // fills an empty tree with count elements whose keys keyAt(0..count)
+    // are strictly increasing, in O(count). the leaves go into one block and
+    // are filled as evenly as the count allows, all but full, on up to
+    // threads threads, a disjoint range of leaves each. the inner levels,
+    // a CAPACITY-th of the nodes, are then built over them. may throw
+    // bad_alloc, in which case the tree stays empty
+    template <typename KeyAt, typename ValueAt>
+    void assignSorted(int count, const KeyAt& keyAt, const ValueAt& valueAt,
+                      int threads = 1)
+    {
+        clear();
+        if (count <= 0) {
+            return;
+        }
+        const int leafCount = (count + CAPACITY - 1) / CAPACITY;
+        void* leafBlock = leaves.allocateBlock(leafCount);
+        auto leafAt = [leafBlock](const int i) {
+            return static_cast<Leaf*>(NodePool<Leaf>::slotOf(leafBlock, i));
+        };
+        const int grain = PARALLEL_BUILD_MIN / CAPACITY;
+        // every leaf exists, empty, before the first entry is copied, so a
+        // copy that throws leaves only whole leaves to clean up
+        parallelFor(0, leafCount, threads, grain,
+                    [&leafAt](const int begin, const int end) {
+            for (int i = begin; i < end; i++) {
+                new (leafAt(i)) Leaf();
+            }
+        });
+        try {
+            parallelFor(0, leafCount, threads, grain,
+                        [&](const int begin, const int end) {
+                for (int i = begin; i < end; i++) {
+                    Leaf* leaf = leafAt(i);
+                    const int last = partStart(i + 1, count, leafCount);
+                    for (int element = partStart(i, count, leafCount);
+                         element < last; element++) {
+                        leaf->keys[leaf->count] = keyAt(element);
+                        new (&leaf->entries()[leaf->count])
+                            Entry(leaf->keys[leaf->count], valueAt(element));
+                        leaf->count++;
+                    }
+                }
+            });
+            root = buildInnerLevels(leafBlock, leafCount);
+        }
+        catch (...) {
+            for (int i = 0; i < leafCount; i++) {
+                destruct(leafAt(i));
+            }
+            leaves.releaseAll();
+            inners.releaseAll();
+            throw;
+        }
+    }
+
+    void clear(int threads = 1)
+    {
+        (void)threads;
+        destruct(root);
+        root = nullptr;
+        leaves.releaseAll();
+        inners.releaseAll();
+    }
+
+    TreeMemory memoryUsage() const
+    {
+        TreeMemory usage = leaves.memoryUsage();
+        usage += inners.memoryUsage();
+        return usage;
+    }
+
+    // nodes are kept at least half full by construction and freed ones are
+    // reused, so there is nothing to compact
+    void compact()
+    {
+    }
+
+    // nodes always come from the heap, placement is ignored
+    void setPlacement(const MemoryPlacement&)
+    {
+    }
+
+    // calls function(value) for every element in key order
+    template <typename Function>
+    void forEachValue(Function function)
+    {
+        auto valueFunction = [&function](const KeyType&, ValueType& value) {
+            function(value);
+        };
+        if (root != nullptr) {
+            inorder(root, valueFunction);
+        }
+    }
+
+    template <typename Function>
+    void forEachValue(Function function) const
+    {
+        auto constFunction = [&function](const KeyType&,
+                                         const ValueType& value) {
+            function(value);
+        };
+        if (root != nullptr) {
+            inorder(root, constFunction);
+        }
+    }
+
+    // calls function(key, value) for every element in key order
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        auto constFunction = [&function](const KeyType& key,
+                                         const ValueType& value) {
+            function(key, value);
+        };
+        if (root != nullptr) {
+            inorder(root, constFunction);
+        }
+    }
+
+
+};
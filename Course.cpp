@@ -8,29 +8,201 @@ Course::Course(const int courseCredit) : courseCredit(courseCredit)
 {
 }
 
-bool Course::enroll(const int studentId, Student& student)
+int Course::seatsFreedBy(const int count) const
 {
-    if( enrolledStudents.insert(studentId, &student)) {
-        student.enroll(); // update student
-        return true;
+    if (capacity == 0) {
+        // nobody waits for an unlimited course
+        return 0;
+    }
+    const int freeSeats = capacity - (enrolledCnt - count);
+    if (freeSeats <= 0) {
+        return 0;
+    }
+    return freeSeats < waitlist.getSize() ? freeSeats : waitlist.getSize();
+}
+
+void Course::seatFromWaitlist(const int count)
+{
+    int seated = 0;
+    try {
+        for (; seated < count; seated++) {
+            enrolledStudents.insert(waitlist.studentAt(seated + 1),
+                                    waitlist.handleAt(seated + 1));
+        }
+    }
+    catch (...) {
+        unseatFromWaitlist(seated);
+        throw;
     }
-    return false;
 }
 
-bool Course::complete(const int studentId)
+void Course::unseatFromWaitlist(const int count)
+{
+    for (int i = 1; i <= count; i++) {
+        enrolledStudents.erase(waitlist.studentAt(i));
+    }
+}
+
+void Course::finishSeating(const int count)
+{
+    for (int i = 0; i < count; i++) {
+        StudentStore::Handle student;
+        waitlist.remove(waitlist.studentAt(1), student);
+    }
+    enrolledCnt += count;
+}
+
+bool Course::enroll(const int studentId, const StudentStore::Handle student,
+                    StudentStore& students)
+{
+    if (isEnrolled(studentId) || waitlist.getPosition(studentId) != 0) {
+        return false;
+    }
+    if (hasFreeSeat()) {
+        enrolledStudents.insert(studentId, student);
+        enrolledCnt++;
+    }
+    else {
+        waitlist.push(studentId, student);
+    }
+    students.enroll(student); // a place in line counts as a course too
+    return true;
+}
+
+bool Course::complete(const int studentId, StudentStore& students)
 {
     auto* findResult = enrolledStudents.find(studentId);
 
     if (!findResult) return false;
 
-    Student* student = findResult->getValue();
-    student->unenroll();
-    student->addCompletionPoints(courseCredit);
+    const StudentStore::Handle student = findResult->getValue();
+    const int promoted = seatsFreedBy(1);
+    seatFromWaitlist(promoted); // may throw, so first
+    try {
+        students.addCompletionPoints(student, courseCredit); // may throw too
+    }
+    catch (...) {
+        unseatFromWaitlist(promoted);
+        throw;
+    }
+    students.unenroll(student);
+    enrolledStudents.erase(findResult);
+    enrolledCnt--;
+    completedCnt++;
+    finishSeating(promoted);
+    return true;
+}
+
+bool Course::withdraw(const int studentId, StudentStore& students)
+{
+    StudentStore::Handle student;
+    if (waitlist.remove(studentId, student)) {
+        students.unenroll(student);
+        return true;
+    }
+    auto* findResult = enrolledStudents.find(studentId);
+    if (findResult == nullptr) {
+        return false;
+    }
+    student = findResult->getValue();
+    const int promoted = seatsFreedBy(1);
+    seatFromWaitlist(promoted); // may throw, so first
+    students.unenroll(student);
     enrolledStudents.erase(findResult);
+    enrolledCnt--;
+    finishSeating(promoted);
     return true;
 }
 
+void Course::assignEnrollments(const int* studentIds,
+                               const StudentStore::Handle* handles,
+                               const int count, const int threads)
+{
+    enrolledStudents.assignSorted(
+        count, [studentIds](const int i) { return studentIds[i]; },
+        [handles](const int i) { return handles[i]; }, threads);
+    enrolledCnt = count;
+}
+
+bool Course::isEnrolled(const int studentId) const
+{
+    return enrolledStudents.find(studentId) != nullptr;
+}
+
+bool Course::hasFreeSeat() const
+{
+    return capacity == 0 || enrolledCnt < capacity;
+}
+
+int Course::nextInLine() const
+{
+    return seatsFreedBy(1) > 0 ? waitlist.studentAt(1) : 0;
+}
+
+int Course::getWaitlistPosition(const int studentId) const
+{
+    return waitlist.getPosition(studentId);
+}
+
+int Course::getWaitlisted(const int position) const
+{
+    return waitlist.studentAt(position);
+}
+
+int Course::seatsOpenedBy(const int newCapacity) const
+{
+    const int freeSeats = newCapacity - enrolledCnt;
+    if (freeSeats <= 0) {
+        return 0;
+    }
+    return freeSeats < waitlist.getSize() ? freeSeats : waitlist.getSize();
+}
+
+void Course::setCapacity(const int newCapacity)
+{
+    const int seated = seatsOpenedBy(newCapacity);
+    seatFromWaitlist(seated);
+    capacity = newCapacity;
+    finishSeating(seated);
+}
+
+int Course::getCredit() const
+{
+    return courseCredit;
+}
+
+CourseStats Course::getStats() const
+{
+    CourseStats stats;
+    stats.enrolled = enrolledCnt;
+    stats.completed = completedCnt;
+    stats.pendingCredits = static_cast<long long>(enrolledCnt) * courseCredit;
+    stats.waitlisted = waitlist.getSize();
+    return stats;
+}
+
+TreeMemory Course::memoryUsage() const
+{
+    TreeMemory usage = enrolledStudents.memoryUsage();
+    usage += waitlist.memoryUsage();
+    return usage;
+}
+
+void Course::compact()
+{
+    enrolledStudents.compact();
+    waitlist.compact();
+}
+
+void Course::remapStudents(const DynamicArray<StudentStore::Handle>& remap)
+{
+    enrolledStudents.forEachValue([&remap](StudentStore::Handle& student) {
+        student = remap[student];
+    });
+    waitlist.remapStudents(remap);
+}
+
 bool Course::isEmpty() const
 {
-    return enrolledStudents.isEmpty();
+    return enrolledStudents.isEmpty() && waitlist.getSize() == 0;
 }
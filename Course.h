@@ -6,22 +6,107 @@
 #define DS_WET_1_COURSE_H
 
 
-#include "Student.h"
+#include "StudentStore.h"
 #include "AvlTree.h"
+#include "Waitlist.h"
+
+struct CourseStats
+{
+    int enrolled = 0; // currently enrolled students
+    int completed = 0; // completions over the lifetime of the course
+    long long pendingCredits = 0; // credits the enrolled students will get
+    int waitlisted = 0; // students waiting for a seat
+};
 
 class Course
 {
     int courseCredit;
+    int capacity = 0; // seat limit, 0 for none
+    int enrolledCnt = 0;
+    int completedCnt = 0;
+
+    AvlTree<int, StudentStore::Handle> enrolledStudents;
+    Waitlist waitlist;
+
+    // seats given to the waitlist if count seated students left now
+    int seatsFreedBy(int count) const;
+
+    // enrolls the first count waitlisted students, who stay on the waitlist
+    // until finishSeating(count). may throw bad_alloc, in which case nothing
+    // changed
+    void seatFromWaitlist(int count);
 
-    AvlTree<int, Student*> enrolledStudents;
+    // undoes seatFromWaitlist(count)
+    void unseatFromWaitlist(int count);
+
+    void finishSeating(int count);
 
 public:
 
     explicit Course(int courseCredit);
 
-    bool enroll(int studentId, Student& student);
+    // enrolls the student, or puts them at the end of the waitlist if the
+    // course is full. false if they're already enrolled or waiting
+    bool enroll(int studentId, StudentStore::Handle student, StudentStore& students);
+
+    // a seat freed by completing goes to the first waitlisted student
+    bool complete(int studentId, StudentStore& students);
+
+    // takes the student out of the course, or off its waitlist, with no
+    // credit. a seat freed goes to the first waitlisted student. false if
+    // the student was neither enrolled nor waiting
+    bool withdraw(int studentId, StudentStore& students);
+
+    // fills an empty course from enrollments sorted by student id. the
+    // students' course counts are left to the caller, so that courses can be
+    // filled concurrently. may throw bad_alloc, in which case the course
+    // stays empty
+    void assignEnrollments(const int* studentIds,
+                           const StudentStore::Handle* handles, int count,
+                           int threads);
+
+    bool isEnrolled(int studentId) const;
+
+    // calls function(studentId) for every enrolled student in id order
+    template <typename Function>
+    void forEachEnrolled(Function function) const
+    {
+        enrolledStudents.forEach([&function](const int studentId,
+                                             StudentStore::Handle) {
+            function(studentId);
+        });
+    }
+
+    bool hasFreeSeat() const;
+
+    // the student a seat freed now would go to, 0 for nobody
+    int nextInLine() const;
+
+    // 1 for the first in line, 0 if the student isn't waiting
+    int getWaitlistPosition(int studentId) const;
+
+    // caller must ensure 1 <= position <= the waitlist length
+    int getWaitlisted(int position) const;
+
+    // number of waitlisted students setCapacity(newCapacity) would seat
+    int seatsOpenedBy(int newCapacity) const;
+
+    // limits the course to newCapacity > 0 seats, seating waitlisted
+    // students in any new ones. students beyond a lowered limit stay
+    // enrolled. may throw bad_alloc, in which case the course is unchanged
+    void setCapacity(int newCapacity);
+
+    int getCredit() const;
+
+    CourseStats getStats() const;
+
+    TreeMemory memoryUsage() const;
+
+    // may throw bad_alloc, in which case the course is unchanged
+    void compact();
 
-    bool complete(int studentId);
+    // replaces every student handle h by remap[h]
+    void remapStudents(const DynamicArray<StudentStore::Handle>& remap);
 
     bool isEmpty() const;
 };
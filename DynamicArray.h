@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#include "PageArena.h"
+
+// growable array of trivially copyable values, for dense per-field storage.
+// the values are on the heap unless the array is placed, in which case they
+// get a mapping of their own, in whole huge pages that the capacity fills
+template <typename T>
+class DynamicArray {
+    T* data = nullptr;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    MemoryPlacement placement;
+
+    // the capacity that room for count values comes to
+    std::size_t roomFor(const std::size_t count) const {
+        return placement.placed
+                   ? PageArena::mappedSize(count * sizeof(T)) / sizeof(T)
+                   : count;
+    }
+
+    // may throw bad_alloc
+    static T* allocate(const std::size_t room, const MemoryPlacement& where) {
+        if (where.placed) {
+            return static_cast<T*>(PageArena::mapPages(room * sizeof(T), where));
+        }
+        return new T[room];
+    }
+
+    static void deallocate(T* values, const std::size_t room,
+                           const MemoryPlacement& where) {
+        if (values != nullptr && where.placed) {
+            PageArena::unmapPages(values, room * sizeof(T));
+        }
+        else {
+            delete[] values;
+        }
+    }
+
+public:
+
+    DynamicArray() = default;
+
+    DynamicArray(const DynamicArray&) = delete;
+
+    DynamicArray& operator=(const DynamicArray&) = delete;
+
+    ~DynamicArray() {
+        deallocate(data, capacity, placement);
+    }
+
+    void swap(DynamicArray& other) noexcept {
+        T* tempData = data;
+        data = other.data;
+        other.data = tempData;
+        const std::size_t tempSize = size;
+        size = other.size;
+        other.size = tempSize;
+        const std::size_t tempCapacity = capacity;
+        capacity = other.capacity;
+        other.capacity = tempCapacity;
+        const MemoryPlacement tempPlacement = placement;
+        placement = other.placement;
+        other.placement = tempPlacement;
+    }
+
+    // may throw bad_alloc, in which case the array is unchanged
+    void reserve(const std::size_t newCapacity) {
+        if (newCapacity <= capacity) {
+            return;
+        }
+        const std::size_t room = roomFor(newCapacity);
+        T* newData = allocate(room, placement);
+        for (std::size_t i = 0; i < size; i++) {
+            newData[i] = data[i];
+        }
+        deallocate(data, capacity, placement);
+        data = newData;
+        capacity = room;
+    }
+
+    // makes room for one more element, growing geometrically
+    void reserveNext() {
+        if (size == capacity) {
+            reserve(capacity == 0 ? 16 : capacity * 2);
+        }
+    }
+
+    // resizes to newSize elements, any new ones left unset. may throw
+    // bad_alloc, in which case the array is unchanged
+    void resize(const std::size_t newSize) {
+        reserve(newSize);
+        size = newSize;
+    }
+
+    // drops the elements from newSize on
+    void truncate(const std::size_t newSize) {
+        if (newSize < size) {
+            size = newSize;
+        }
+    }
+
+    // gives unused capacity back. keeps it if the smaller copy can't be made
+    void shrinkToFit() {
+        const std::size_t room = size > 0 ? roomFor(size) : 0;
+        if (room >= capacity) {
+            return;
+        }
+        T* newData = nullptr;
+        if (size > 0) {
+            try {
+                newData = allocate(room, placement);
+            }
+            catch (const std::bad_alloc&) {
+                return;
+            }
+            for (std::size_t i = 0; i < size; i++) {
+                newData[i] = data[i];
+            }
+        }
+        deallocate(data, capacity, placement);
+        data = newData;
+        capacity = room;
+    }
+
+    // moves the values into memory placed as asked, with no more room than
+    // they need, and keeps them there as the array grows. may throw
+    // bad_alloc, in which case the array is unchanged
+    void setPlacement(const MemoryPlacement& newPlacement) {
+        DynamicArray moved;
+        moved.placement = newPlacement;
+        moved.reserve(size);
+        for (std::size_t i = 0; i < size; i++) {
+            moved.data[i] = data[i];
+        }
+        moved.size = size;
+        swap(moved);
+    }
+
+    void pushBack(const T& value) {
+        reserveNext();
+        data[size++] = value;
+    }
+
+    T& operator[](const std::size_t index) {
+        return data[index];
+    }
+
+    const T& operator[](const std::size_t index) const {
+        return data[index];
+    }
+
+    std::size_t getSize() const {
+        return size;
+    }
+
+    std::size_t getCapacity() const {
+        return capacity;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <exception>
+#include <pthread.h>
+#include <unistd.h>
+
+// Runs first on a new thread and second on the calling one, and returns
+// once both are done. If no thread can be started both run here, one after
+// the other. An exception thrown by either side is rethrown after the join.
+template <typename First, typename Second>
+void forkJoin(First& first, Second& second)
+{
+    struct Task {
+        First* function;
+        std::exception_ptr error;
+
+        static void* run(void* arg) {
+            Task* task = static_cast<Task*>(arg);
+            try {
+                (*task->function)();
+            }
+            catch (...) {
+                task->error = std::current_exception();
+            }
+            return nullptr;
+        }
+    };
+
+    Task task{&first, nullptr};
+    pthread_t thread;
+    const bool forked =
+        pthread_create(&thread, nullptr, &Task::run, &task) == 0;
+    if (!forked) {
+        Task::run(&task);
+    }
+
+    std::exception_ptr secondError;
+    try {
+        second();
+    }
+    catch (...) {
+        secondError = std::current_exception();
+    }
+
+    if (forked) {
+        pthread_join(thread, nullptr);
+    }
+    if (task.error) {
+        std::rethrow_exception(task.error);
+    }
+    if (secondError) {
+        std::rethrow_exception(secondError);
+    }
+}
+
+// Calls function(begin, end) on disjoint ranges that cover [begin, end), on
+// up to threads threads. A range is only split while both halves get at
+// least grain elements.
+template <typename Function>
+void parallelFor(int begin, int end, int threads, int grain,
+                 const Function& function)
+{
+    if (threads < 2 || end - begin < 2 * grain) {
+        function(begin, end);
+        return;
+    }
+    const int mid = begin + (end - begin) / 2;
+    auto first = [&]() {
+        parallelFor(begin, mid, threads / 2, grain, function);
+    };
+    auto second = [&]() {
+        parallelFor(mid, end, threads - threads / 2, grain, function);
+    };
+    forkJoin(first, second);
+}
+
+inline int availableCores()
+{
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? static_cast<int>(cores) : 1;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#include "PageArena.h"
+
+// bytes a container holds for its live elements, and in total from the heap
+struct TreeMemory {
+    std::size_t liveBytes = 0;
+    std::size_t reservedBytes = 0;
+
+    TreeMemory& operator+=(const TreeMemory& other) {
+        liveBytes += other.liveBytes;
+        reservedBytes += other.reservedBytes;
+        return *this;
+    }
+};
+
+// Storage for the nodes of one tree. Nodes are carved out of chunks that
+// double in size up to MAX_CHUNK, and freed nodes go on a free list for
+// reuse. Chunks come from a PageArena, the heap unless the pool was given a
+// MemoryPlacement, and are only given back all at once, by releaseAll() or
+// by the destructor; a tree compacts by moving its nodes into a fresh pool
+// with a single exact-size block and dropping the old one.
+// The pool only hands out storage, constructing and destroying the objects
+// in it is up to the caller.
+template <typename T>
+class NodePool {
+    union Slot {
+        Slot* nextFree;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct alignas(Slot) Chunk {
+        std::size_t capacity;
+        std::size_t used;
+
+        Slot* slots() {
+            return reinterpret_cast<Slot*>(this + 1);
+        }
+    };
+
+    static const std::size_t MIN_CHUNK = 4;
+    static const std::size_t MAX_CHUNK = 4096;
+
+    PageArena arena;
+    Chunk* current = nullptr; // the chunk allocate() carves from
+    Slot* freeList = nullptr;
+    std::size_t liveCount = 0;
+
+    Chunk* newChunk(const std::size_t capacity) {
+        const std::size_t bytes = sizeof(Chunk) + capacity * sizeof(Slot);
+        Chunk* chunk = new (arena.allocate(bytes)) Chunk{capacity, 0};
+        current = chunk;
+        return chunk;
+    }
+
+public:
+
+    NodePool() = default;
+
+    explicit NodePool(const MemoryPlacement& placement) : arena(placement) {}
+
+    NodePool(const NodePool&) = delete;
+
+    NodePool& operator=(const NodePool&) = delete;
+
+    NodePool(NodePool&& other) noexcept {
+        swap(other);
+    }
+
+    ~NodePool() {
+        releaseAll();
+    }
+
+    void swap(NodePool& other) noexcept {
+        arena.swap(other.arena);
+        Chunk* tempCurrent = current;
+        current = other.current;
+        other.current = tempCurrent;
+        Slot* tempFree = freeList;
+        freeList = other.freeList;
+        other.freeList = tempFree;
+        const std::size_t tempLive = liveCount;
+        liveCount = other.liveCount;
+        other.liveCount = tempLive;
+    }
+
+    // storage for one object. may throw bad_alloc
+    void* allocate() {
+        if (freeList != nullptr) {
+            Slot* slot = freeList;
+            freeList = slot->nextFree;
+            liveCount++;
+            return slot;
+        }
+        if (current == nullptr || current->used == current->capacity) {
+            std::size_t capacity = MIN_CHUNK;
+            if (current != nullptr) {
+                capacity = current->capacity * 2 < MAX_CHUNK
+                               ? current->capacity * 2 : MAX_CHUNK;
+            }
+            newChunk(capacity);
+        }
+        liveCount++;
+        return &current->slots()[current->used++];
+    }
+
+    // storage for count objects at consecutive slotOf(block, i) addresses.
+    // may throw bad_alloc
+    void* allocateBlock(const std::size_t count) {
+        Chunk* chunk = newChunk(count);
+        chunk->used = count;
+        liveCount += count;
+        return chunk->slots();
+    }
+
+    static void* slotOf(void* block, const std::size_t index) {
+        return static_cast<Slot*>(block) + index;
+    }
+
+    // the object in storage must already be destroyed
+    void deallocate(void* storage) {
+        Slot* slot = static_cast<Slot*>(storage);
+        slot->nextFree = freeList;
+        freeList = slot;
+        liveCount--;
+    }
+
+    // gives every chunk back. all objects must already be destroyed
+    void releaseAll() {
+        arena.releaseAll();
+        current = nullptr;
+        freeList = nullptr;
+        liveCount = 0;
+    }
+
+    std::size_t size() const {
+        return liveCount;
+    }
+
+    TreeMemory memoryUsage() const {
+        TreeMemory usage;
+        usage.liveBytes = liveCount * sizeof(T);
+        usage.reservedBytes = arena.getReservedBytes();
+        return usage;
+    }
+
+    const MemoryPlacement& getPlacement() const {
+        return arena.getPlacement();
+    }
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Where a NodePool, or a DynamicArray, gets its memory. By default that's
+// the heap. A placed pool instead carves its chunks out of 2 MB aligned
+// regions mapped straight from the kernel, and a placed array gets such a
+// region of its own. Those regions can be backed by transparent huge pages,
+// so a large tree needs far fewer TLB entries, and can be bound to one NUMA
+// node, so a system serving one socket keeps its nodes local.
+struct MemoryPlacement {
+    bool placed = false; // false for the heap, and the fields below unused
+    bool hugePages = false; // madvise the regions for THP, or against it
+    int numaNode = -1; // node to bind the regions to, -1 for no binding
+};
+
+// Memory handed out in cache line aligned pieces and given back all at once.
+class PageArena {
+    static const std::size_t HUGE_PAGE = std::size_t(1) << 21;
+    static const std::size_t PIECE_ALIGN = 64;
+
+    struct alignas(PIECE_ALIGN) Region {
+        Region* next;
+        std::size_t bytes; // including this header
+        std::size_t used;
+    };
+
+    MemoryPlacement placement;
+    Region* regions = nullptr; // the head is the one allocate() carves from
+    std::size_t reservedBytes = 0;
+
+    static std::size_t roundUp(const std::size_t bytes, const std::size_t unit) {
+        return (bytes + unit - 1) / unit * unit;
+    }
+
+    Region* mapRegion(const std::size_t bytes) const {
+        return static_cast<Region*>(mapPages(bytes, placement));
+    }
+
+    void freeRegion(Region* region) const {
+        if (placement.placed) {
+            munmap(region, region->bytes);
+        }
+        else {
+            std::free(region);
+        }
+    }
+
+public:
+
+    // size of the mapping mapPages makes for bytes: whole huge pages
+    static std::size_t mappedSize(const std::size_t bytes) {
+        return roundUp(bytes, HUGE_PAGE);
+    }
+
+    // maps mappedSize(bytes) zeroed bytes at a huge page boundary and applies
+    // placement, which must be placed, before anything touches the pages.
+    // For memory that is not carved into pieces, such as one large array.
+    // throws bad_alloc if either fails
+    static void* mapPages(std::size_t bytes, const MemoryPlacement& placement) {
+        bytes = mappedSize(bytes);
+        // over-map by a huge page and trim, to get the alignment
+        const std::size_t mapped = bytes + HUGE_PAGE;
+        void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(memory);
+        const std::uintptr_t aligned = roundUp(start, HUGE_PAGE);
+        if (aligned > start) {
+            munmap(memory, aligned - start);
+        }
+        if (start + mapped > aligned + bytes) {
+            munmap(reinterpret_cast<void*>(aligned + bytes),
+                   start + mapped - (aligned + bytes));
+        }
+        void* region = reinterpret_cast<void*>(aligned);
+
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+        madvise(region, bytes, placement.hugePages ? MADV_HUGEPAGE
+                                                   : MADV_NOHUGEPAGE);
+#endif
+        if (placement.numaNode >= 0) {
+            bool bound = false;
+#ifdef SYS_mbind
+            const int MPOL_BIND = 2;
+            const std::size_t maskBits = 8 * sizeof(unsigned long);
+            unsigned long mask[4] = {};
+            const std::size_t node = placement.numaNode;
+            if (node < 4 * maskBits) {
+                mask[node / maskBits] = 1ul << (node % maskBits);
+                bound = syscall(SYS_mbind, region, bytes, MPOL_BIND, mask,
+                                4 * maskBits + 1, 0) == 0;
+            }
+#endif
+            if (!bound) {
+                munmap(region, bytes);
+                throw std::bad_alloc();
+            }
+        }
+        return region;
+    }
+
+    // gives back what mapPages(bytes, ...) returned
+    static void unmapPages(void* pages, const std::size_t bytes) {
+        munmap(pages, mappedSize(bytes));
+    }
+
+    PageArena() = default;
+
+    explicit PageArena(const MemoryPlacement& placement)
+        : placement(placement) {}
+
+    PageArena(const PageArena&) = delete;
+
+    PageArena& operator=(const PageArena&) = delete;
+
+    ~PageArena() {
+        releaseAll();
+    }
+
+    void swap(PageArena& other) noexcept {
+        const MemoryPlacement tempPlacement = placement;
+        placement = other.placement;
+        other.placement = tempPlacement;
+        Region* tempRegions = regions;
+        regions = other.regions;
+        other.regions = tempRegions;
+        const std::size_t tempReserved = reservedBytes;
+        reservedBytes = other.reservedBytes;
+        other.reservedBytes = tempReserved;
+    }
+
+    // bytes starting at a cache line. may throw bad_alloc
+    void* allocate(std::size_t bytes) {
+        bytes = roundUp(bytes, PIECE_ALIGN);
+        const std::size_t offset = sizeof(Region);
+        if (!placement.placed) {
+            // every piece is a heap block of its own
+            void* memory = nullptr;
+            if (posix_memalign(&memory, PIECE_ALIGN, offset + bytes) != 0) {
+                throw std::bad_alloc();
+            }
+            Region* region = new (memory)
+                Region{regions, offset + bytes, offset + bytes};
+            regions = region;
+            reservedBytes += region->bytes;
+            return region + 1;
+        }
+        if (regions == nullptr || regions->used + bytes > regions->bytes) {
+            const std::size_t regionBytes = roundUp(offset + bytes, HUGE_PAGE);
+            Region* region = new (mapRegion(regionBytes))
+                Region{regions, regionBytes, offset};
+            regions = region;
+            reservedBytes += regionBytes;
+        }
+        void* piece = reinterpret_cast<unsigned char*>(regions) + regions->used;
+        regions->used += bytes;
+        return piece;
+    }
+
+    // gives every region back. all objects in them must already be destroyed
+    void releaseAll() {
+        while (regions != nullptr) {
+            Region* next = regions->next;
+            freeRegion(regions);
+            regions = next;
+        }
+        reservedBytes = 0;
+    }
+
+    const MemoryPlacement& getPlacement() const {
+        return placement;
+    }
+
+    std::size_t getReservedBytes() const {
+        return reservedBytes;
+    }
+};
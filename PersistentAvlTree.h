@@ -0,0 +1,419 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "ForkJoin.h"
+#include "NodePool.h"
+
+// Persistent AVL tree. Copying a tree is O(1) and yields an independent
+// version, which can be read (and dropped) on another thread while the
+// original keeps changing. Versions share nodes, which are reference
+// counted and freed when the last version holding them goes away.
+// An update walks its search path and changes in place every node that this
+// version holds alone, copying only the ones still shared with another
+// version, so a tree that is never copied updates like a plain AVL tree and
+// one that is pays O(log n) copies once per shared path.
+
+template <typename KeyType, typename ValueType>
+class PersistentAvlTree {
+
+    // a node with refs > 1 is reachable from more than one version and must
+    // not change, a node with refs == 1 belongs to whoever reached it
+    struct Node {
+        KeyType key;
+        ValueType value;
+        Node* left;
+        Node* right;
+        int height;
+        std::atomic<int> refs;
+
+        Node(const KeyType& k, const ValueType& v, Node* l, Node* r, int h)
+            : key(k), value(v), left(l), right(r), height(h), refs(1) {}
+    };
+
+    // enough for any AVL tree that fits in memory
+    static const int MAX_DEPTH = 64;
+
+    static void acquire(Node* node) {
+        if (node != nullptr) {
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void release(Node* node) {
+        if (node != nullptr &&
+            node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            release(node->left);
+            release(node->right);
+            delete node;
+        }
+    }
+
+    // subtrees below this height are not worth a thread of their own
+    static const int PARALLEL_RELEASE_MIN_HEIGHT = 14;
+
+    // like release, freeing the two subtrees of a node this drops the last
+    // reference to on up to threads threads
+    static void release(Node* node, const int threads) {
+        if (threads < 2 || getHeight(node) < PARALLEL_RELEASE_MIN_HEIGHT) {
+            release(node);
+            return;
+        }
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            auto releaseLeft = [node, threads]() {
+                release(node->left, threads / 2);
+            };
+            auto releaseRight = [node, threads]() {
+                release(node->right, threads - threads / 2);
+            };
+            forkJoin(releaseLeft, releaseRight);
+            delete node;
+        }
+    }
+
+    // owns one reference to a node, so that partially built subtrees are
+    // released if an allocation throws halfway through a build
+    class Ref {
+        Node* node = nullptr;
+
+    public:
+        Ref() = default;
+
+        explicit Ref(Node* n) : node(n) {}
+
+        Ref(Ref&& other) noexcept : node(other.node) {
+            other.node = nullptr;
+        }
+
+        Ref(const Ref&) = delete;
+
+        Ref& operator=(const Ref&) = delete;
+
+        ~Ref() {
+            release(node);
+        }
+
+        Node* get() const {
+            return node;
+        }
+
+        Node* take() {
+            Node* taken = node;
+            node = nullptr;
+            return taken;
+        }
+    };
+
+    Node* root = nullptr;
+
+    static int getHeight(const Node* node) {
+        return node == nullptr ? -1 : node->height;
+    }
+
+    static void updateHeight(Node* node) {
+        const int leftHeight = getHeight(node->left);
+        const int rightHeight = getHeight(node->right);
+        node->height = (leftHeight >= rightHeight ? leftHeight : rightHeight) + 1;
+    }
+
+    // makes the node in slot one that only this version holds, copying it
+    // if it is shared. the copy shares the children of the original, so the
+    // tree keeps its contents. may throw bad_alloc, leaving slot as it was
+    static Node* unique(Node*& slot) {
+        Node* node = slot;
+        if (node->refs.load(std::memory_order_acquire) != 1) {
+            Node* copy = new Node(node->key, node->value, node->left,
+                                  node->right, node->height);
+            acquire(copy->left);
+            acquire(copy->right);
+            slot = copy;
+            release(node);
+            node = copy;
+        }
+        return node;
+    }
+
+    // the rotations only relink nodes this version holds alone
+    static void rotateRight(Node*& slot) {
+        Node* node = slot;
+        Node* pivot = node->left;
+        node->left = pivot->right;
+        updateHeight(node);
+        pivot->right = node;
+        updateHeight(pivot);
+        slot = pivot;
+    }
+
+    static void rotateLeft(Node*& slot) {
+        Node* node = slot;
+        Node* pivot = node->right;
+        node->right = pivot->left;
+        updateHeight(node);
+        pivot->left = node;
+        updateHeight(pivot);
+        slot = pivot;
+    }
+
+    static void rebalance(Node*& slot) {
+        Node* node = slot;
+        const int balance = getHeight(node->left) - getHeight(node->right);
+        if (balance > 1) {
+            if (getHeight(node->left->left) < getHeight(node->left->right)) {
+                rotateLeft(node->left); // LR
+            }
+            rotateRight(slot);
+        }
+        else if (balance < -1) {
+            if (getHeight(node->right->right) < getHeight(node->right->left)) {
+                rotateRight(node->right); // RL
+            }
+            rotateLeft(slot);
+        }
+        else {
+            updateHeight(node);
+        }
+    }
+
+    // before an erase below node, takes its child on the other side, and
+    // that child's inner child, if the erase can rotate them up
+    static void uniqueSibling(Node* node, const bool goingLeft) {
+        Node*& sibling = goingLeft ? node->right : node->left;
+        const Node* child = goingLeft ? node->left : node->right;
+        if (sibling == nullptr || getHeight(sibling) <= getHeight(child)) {
+            return;
+        }
+        Node* taken = unique(sibling);
+        Node*& inner = goingLeft ? taken->left : taken->right;
+        const Node* outer = goingLeft ? taken->right : taken->left;
+        if (inner != nullptr && getHeight(inner) > getHeight(outer)) {
+            unique(inner);
+        }
+    }
+
+    // builds a perfectly balanced tree of the elements [low, high)
+    template <typename KeyAt, typename ValueAt>
+    static Ref build(const KeyAt& keyAt, const ValueAt& valueAt, int low,
+                     int high) {
+        if (low >= high) {
+            return Ref();
+        }
+        const int mid = low + (high - low) / 2;
+        Ref left = build(keyAt, valueAt, low, mid);
+        Ref right = build(keyAt, valueAt, mid + 1, high);
+        Node* node = new Node(keyAt(mid), valueAt(mid), left.get(),
+                              right.get(), 0);
+        left.take();
+        right.take();
+        updateHeight(node);
+        return Ref(node);
+    }
+
+    static std::size_t countNodes(const Node* node) {
+        return node == nullptr
+                   ? 0 : 1 + countNodes(node->left) + countNodes(node->right);
+    }
+
+    template <typename Function>
+    static void inorder(const Node* node, Function& function) {
+        if (node == nullptr) {
+            return;
+        }
+        inorder(node->left, function);
+        function(node->key, node->value);
+        inorder(node->right, function);
+    }
+
+public:
+
+    PersistentAvlTree() = default;
+
+    PersistentAvlTree(const PersistentAvlTree& other) : root(other.root) {
+        acquire(root);
+    }
+
+    PersistentAvlTree(PersistentAvlTree&& other) noexcept : root(other.root) {
+        other.root = nullptr;
+    }
+
+    PersistentAvlTree& operator=(const PersistentAvlTree& other) {
+        acquire(other.root);
+        release(root);
+        root = other.root;
+        return *this;
+    }
+
+    PersistentAvlTree& operator=(PersistentAvlTree&& other) noexcept {
+        if (this != &other) {
+            release(root);
+            root = other.root;
+            other.root = nullptr;
+        }
+        return *this;
+    }
+
+    ~PersistentAvlTree() {
+        release(root);
+    }
+
+    const ValueType* find(const KeyType& key) const
+    {
+        const Node* current = root;
+        while (current != nullptr) {
+            if (key < current->key) {
+                current = current->left;
+            }
+            else if (current->key < key) {
+                current = current->right;
+            }
+            else {
+                return &current->value;
+            }
+        }
+        return nullptr;
+    }
+
+    // the value of key, to be changed in place, or nullptr if key is not in
+    // the tree. other versions keep seeing the old value. may throw
+    // bad_alloc, in which case the tree keeps its contents
+    ValueType* findForUpdate(const KeyType& key)
+    {
+        if (find(key) == nullptr) {
+            return nullptr;
+        }
+        Node** slot = &root;
+        while (true) {
+            Node* node = unique(*slot);
+            if (key < node->key) {
+                slot = &node->left;
+            }
+            else if (node->key < key) {
+                slot = &node->right;
+            }
+            else {
+                return &node->value;
+            }
+        }
+    }
+
+    // inserts key or replaces its value. may throw bad_alloc, in which case
+    // the tree keeps its contents
+    void assign(const KeyType& key, const ValueType& value)
+    {
+        // every node that can change is taken before the first one does
+        Node** path[MAX_DEPTH];
+        int depth = 0;
+        Node** slot = &root;
+        while (*slot != nullptr) {
+            Node* node = unique(*slot);
+            if (key < node->key) {
+                path[depth++] = slot;
+                slot = &node->left;
+            }
+            else if (node->key < key) {
+                path[depth++] = slot;
+                slot = &node->right;
+            }
+            else {
+                node->value = value;
+                return;
+            }
+        }
+        *slot = new Node(key, value, nullptr, nullptr, 0);
+        while (depth > 0) {
+            rebalance(*path[--depth]);
+        }
+    }
+
+    bool erase(const KeyType& key) // false if doesnt exist
+    {
+        if (find(key) == nullptr) {
+            return false;
+        }
+        // take the path down to the node and on to its successor, and the
+        // siblings a rebalance can rotate up, before changing anything
+        Node** path[MAX_DEPTH];
+        int depth = 0;
+        Node** slot = &root;
+        Node* target = unique(*slot);
+        while (key < target->key || target->key < key) {
+            const bool goingLeft = key < target->key;
+            uniqueSibling(target, goingLeft);
+            path[depth++] = slot;
+            slot = goingLeft ? &target->left : &target->right;
+            target = unique(*slot);
+        }
+        if (target->left != nullptr && target->right != nullptr) {
+            // on to the inorder successor
+            uniqueSibling(target, false);
+            path[depth++] = slot;
+            slot = &target->right;
+            Node* node = unique(*slot);
+            while (node->left != nullptr) {
+                uniqueSibling(node, true);
+                path[depth++] = slot;
+                slot = &node->left;
+                node = unique(*slot);
+            }
+        }
+
+        Node* removed = *slot;
+        if (removed != target) {
+            // removed is the successor of target and has no left child
+            target->key = removed->key;
+            target->value = std::move(removed->value);
+        }
+        *slot = removed->left != nullptr ? removed->left : removed->right;
+        removed->left = nullptr;
+        removed->right = nullptr;
+        release(removed);
+        while (depth > 0) {
+            rebalance(*path[--depth]);
+        }
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return root == nullptr;
+    }
+
+    // empties this version. nodes no other version holds are freed on up to
+    // threads threads
+    void clear(int threads = 1)
+    {
+        Node* oldRoot = root;
+        root = nullptr;
+        release(oldRoot, threads);
+    }
+
+    // replaces the contents with count elements whose keys keyAt(0..count)
+    // are strictly increasing, in O(count). may throw bad_alloc, in which
+    // case the tree is unchanged
+    template <typename KeyAt, typename ValueAt>
+    void assignSorted(int count, const KeyAt& keyAt, const ValueAt& valueAt)
+    {
+        Ref newRoot = build(keyAt, valueAt, 0, count);
+        release(root);
+        root = newRoot.take();
+    }
+
+    // bytes of the nodes of this version, each a heap block of its own.
+    // nodes shared with other versions are counted in full, and memory
+    // owned by the values is left to the caller
+    TreeMemory memoryUsage() const
+    {
+        TreeMemory usage;
+        usage.liveBytes = countNodes(root) * sizeof(Node);
+        usage.reservedBytes = usage.liveBytes;
+        return usage;
+    }
+
+    // calls function(key, value) for every element in key order
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        inorder(root, function);
+    }
+
+};
@@ -0,0 +1,301 @@
+#include "StudentStore.h"
+
+const StudentStore::Handle StudentStore::NO_SLOT;
+
+StudentStore::~StudentStore()
+{
+    for (std::size_t i = 0; i < completionLog.getSize(); i++) {
+        deleteLog(completionLog[i]);
+    }
+}
+
+StudentStore::CompletionLog* StudentStore::newLog(const int capacity,
+                                                  const CompletionLog* from)
+{
+    void* memory = ::operator new(sizeof(CompletionLog) +
+                                  capacity * sizeof(CompletionEntry));
+    CompletionLog* log = new (memory) CompletionLog{0, capacity};
+    if (from != nullptr) {
+        for (int i = 0; i < from->count; i++) {
+            log->entries()[i] = from->entries()[i];
+        }
+        log->count = from->count;
+    }
+    return log;
+}
+
+void StudentStore::deleteLog(CompletionLog* log)
+{
+    ::operator delete(log);
+}
+
+int StudentStore::bonusAt(const int time) const
+{
+    return time == 0 ? 0 : awardPrefix[time - 1];
+}
+
+void StudentStore::addToGlobalBonus(const int points)
+{
+    awardPrefix.pushBack(globalBonus + points);
+    globalBonus += points;
+}
+
+int StudentStore::getGlobalBonus() const
+{
+    return globalBonus;
+}
+
+int StudentStore::getCurrentTime() const
+{
+    return static_cast<int>(awardPrefix.getSize());
+}
+
+StudentStore::Handle StudentStore::add()
+{
+    Handle slot;
+    if (freeHead != NO_SLOT) {
+        slot = freeHead;
+        freeHead = nextFree[slot];
+        freeCnt--;
+    }
+    else {
+        // reserve every field first so a bad_alloc can't leave them uneven
+        bonusPenalty.reserveNext();
+        completionPoints.reserveNext();
+        courseCnt.reserveNext();
+        nextFree.reserveNext();
+        joinedAt.reserveNext();
+        completionLog.reserveNext();
+
+        slot = static_cast<Handle>(bonusPenalty.getSize());
+        bonusPenalty.pushBack(0);
+        completionPoints.pushBack(0);
+        courseCnt.pushBack(0);
+        nextFree.pushBack(NO_SLOT);
+        joinedAt.pushBack(0);
+        completionLog.pushBack(nullptr);
+    }
+    bonusPenalty[slot] = globalBonus;
+    completionPoints[slot] = 0;
+    courseCnt[slot] = 0;
+    joinedAt[slot] = getCurrentTime();
+    return slot;
+}
+
+StudentStore::Handle StudentStore::addBulk(const DynamicArray<int>& courseCnts)
+{
+    const std::size_t count = courseCnts.getSize();
+    const std::size_t newSize = bonusPenalty.getSize() + count;
+    // reserve every field first so a bad_alloc can't leave them uneven
+    bonusPenalty.reserve(newSize);
+    completionPoints.reserve(newSize);
+    courseCnt.reserve(newSize);
+    nextFree.reserve(newSize);
+    joinedAt.reserve(newSize);
+    completionLog.reserve(newSize);
+
+    const Handle first = static_cast<Handle>(bonusPenalty.getSize());
+    const int now = getCurrentTime();
+    for (std::size_t i = 0; i < count; i++) {
+        bonusPenalty.pushBack(globalBonus);
+        completionPoints.pushBack(0);
+        courseCnt.pushBack(courseCnts[i]);
+        nextFree.pushBack(NO_SLOT);
+        joinedAt.pushBack(now);
+        completionLog.pushBack(nullptr);
+    }
+    return first;
+}
+
+void StudentStore::removeBulk(const Handle first)
+{
+    for (std::size_t i = first; i < completionLog.getSize(); i++) {
+        deleteLog(completionLog[i]);
+    }
+    bonusPenalty.truncate(first);
+    completionPoints.truncate(first);
+    courseCnt.truncate(first);
+    nextFree.truncate(first);
+    joinedAt.truncate(first);
+    completionLog.truncate(first);
+}
+
+void StudentStore::remove(const Handle student)
+{
+    deleteLog(completionLog[student]);
+    completionLog[student] = nullptr;
+    nextFree[student] = freeHead;
+    freeHead = student;
+    freeCnt++;
+}
+
+void StudentStore::enroll(const Handle student)
+{
+    courseCnt[student]++;
+}
+
+void StudentStore::unenroll(const Handle student)
+{
+    courseCnt[student]--;
+}
+
+void StudentStore::addCompletionPoints(const Handle student, const int points)
+{
+    const int now = getCurrentTime();
+    const int total = completionPoints[student] + points;
+    CompletionLog* log = completionLog[student];
+    if (log != nullptr && log->entries()[log->count - 1].time == now) {
+        // several completions between the same two awards keep one entry
+        log->entries()[log->count - 1].totalPoints = total;
+    }
+    else {
+        if (log == nullptr || log->count == log->capacity) {
+            CompletionLog* grown =
+                newLog(log == nullptr ? 1 : 2 * log->capacity, log);
+            deleteLog(log);
+            log = grown;
+            completionLog[student] = log;
+        }
+        log->entries()[log->count++] = CompletionEntry{now, total};
+    }
+    completionPoints[student] = total;
+}
+
+int StudentStore::getStudentPoints(const Handle student) const
+{
+    return completionPoints[student] + (globalBonus - bonusPenalty[student]);
+}
+
+int StudentStore::getJoinTime(const Handle student) const
+{
+    return joinedAt[student];
+}
+
+int StudentStore::getStudentPointsAsOf(const Handle student, const int time) const
+{
+    int completed = 0;
+    const CompletionLog* log = completionLog[student];
+    if (log != nullptr) {
+        // last completion entry at or before time
+        int low = 0;
+        int high = log->count;
+        while (low < high) {
+            const int mid = low + (high - low) / 2;
+            if (log->entries()[mid].time <= time) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        if (low > 0) {
+            completed = log->entries()[low - 1].totalPoints;
+        }
+    }
+    return completed + (bonusAt(time) - bonusAt(joinedAt[student]));
+}
+
+bool StudentStore::hasAnyCourses(const Handle student) const
+{
+    return courseCnt[student] > 0;
+}
+
+StudentRecord StudentStore::getRecord(const Handle student) const
+{
+    return {bonusPenalty[student], completionPoints[student]};
+}
+
+template <typename T>
+static std::size_t reservedBytes(const DynamicArray<T>& array)
+{
+    return array.getCapacity() * sizeof(T);
+}
+
+TreeMemory StudentStore::memoryUsage() const
+{
+    const std::size_t rowBytes = 4 * sizeof(int) + sizeof(Handle) + sizeof(CompletionLog*);
+    TreeMemory usage;
+    usage.liveBytes = (bonusPenalty.getSize() - freeCnt) * rowBytes;
+    // placed arrays fill whole huge pages, so the capacities can differ
+    usage.reservedBytes = reservedBytes(bonusPenalty) +
+                          reservedBytes(completionPoints) +
+                          reservedBytes(courseCnt) + reservedBytes(nextFree) +
+                          reservedBytes(joinedAt) + reservedBytes(completionLog);
+    usage.liveBytes += awardPrefix.getSize() * sizeof(int);
+    usage.reservedBytes += reservedBytes(awardPrefix);
+    for (std::size_t i = 0; i < completionLog.getSize(); i++) {
+        const CompletionLog* log = completionLog[i];
+        if (log != nullptr) {
+            usage.liveBytes += sizeof(CompletionLog) + log->count * sizeof(CompletionEntry);
+            usage.reservedBytes += sizeof(CompletionLog) + log->capacity * sizeof(CompletionEntry);
+        }
+    }
+    return usage;
+}
+
+void StudentStore::setPlacement(const MemoryPlacement& placement)
+{
+    bonusPenalty.setPlacement(placement);
+    completionPoints.setPlacement(placement);
+    courseCnt.setPlacement(placement);
+    nextFree.setPlacement(placement);
+    joinedAt.setPlacement(placement);
+    completionLog.setPlacement(placement);
+    awardPrefix.setPlacement(placement);
+}
+
+void StudentStore::compact(DynamicArray<Handle>& remap)
+{
+    const std::size_t slots = bonusPenalty.getSize();
+    remap.reserve(slots);
+    for (std::size_t i = 0; i < slots; i++) {
+        remap.pushBack(0);
+    }
+    for (Handle slot = freeHead; slot != NO_SLOT; slot = nextFree[slot]) {
+        remap[slot] = NO_SLOT;
+    }
+
+    Handle next = 0;
+    for (std::size_t i = 0; i < slots; i++) {
+        if (remap[i] == NO_SLOT) {
+            continue;
+        }
+        remap[i] = next;
+        if (next != i) {
+            bonusPenalty[next] = bonusPenalty[i];
+            completionPoints[next] = completionPoints[i];
+            courseCnt[next] = courseCnt[i];
+            joinedAt[next] = joinedAt[i];
+            completionLog[next] = completionLog[i];
+        }
+        next++;
+    }
+
+    bonusPenalty.truncate(next);
+    completionPoints.truncate(next);
+    courseCnt.truncate(next);
+    nextFree.truncate(next);
+    joinedAt.truncate(next);
+    completionLog.truncate(next);
+    for (Handle i = 0; i < next; i++) {
+        // a log left as it is if the smaller copy can't be made
+        CompletionLog* log = completionLog[i];
+        if (log != nullptr && log->count < log->capacity) {
+            try {
+                completionLog[i] = newLog(log->count, log);
+                deleteLog(log);
+            }
+            catch (const std::bad_alloc&) {
+            }
+        }
+    }
+    bonusPenalty.shrinkToFit();
+    completionPoints.shrinkToFit();
+    courseCnt.shrinkToFit();
+    nextFree.shrinkToFit();
+    joinedAt.shrinkToFit();
+    completionLog.shrinkToFit();
+    awardPrefix.shrinkToFit();
+    freeHead = NO_SLOT;
+    freeCnt = 0;
+}
@@ -0,0 +1,144 @@
+#ifndef DS_WET_1_STUDENTSTORE_H
+#define DS_WET_1_STUDENTSTORE_H
+
+#include <cstdint>
+
+#include "DynamicArray.h"
+#include "NodePool.h"
+
+// one student's row of the store, copied out for snapshots
+struct StudentRecord
+{
+    int bonusPenalty;
+    int completionPoints;
+};
+
+// All students of a system, kept structure-of-arrays: slot i of every field
+// array belongs to the same student. Trees refer to students by slot handle,
+// and slots of removed students are reused through a free list.
+//
+// Time is measured in awards: time t is the state after the first t calls
+// to addToGlobalBonus. Awards are kept as a prefix-sum log, and each student
+// keeps the time it joined at and a log of its completions, so points as of
+// any past time are two binary searches away.
+class StudentStore
+{
+public:
+    using Handle = uint32_t;
+
+private:
+    static const Handle NO_SLOT = UINT32_MAX;
+
+    struct CompletionEntry
+    {
+        int time;
+        int totalPoints; // completionPoints as of time
+    };
+
+    // completion history of one student, in increasing time. one heap block
+    // each: this header and then room for capacity entries, starting at one
+    // and doubling, since most students only ever complete a few courses
+    struct CompletionLog
+    {
+        int count;
+        int capacity;
+
+        CompletionEntry* entries()
+        {
+            return reinterpret_cast<CompletionEntry*>(this + 1);
+        }
+
+        const CompletionEntry* entries() const
+        {
+            return reinterpret_cast<const CompletionEntry*>(this + 1);
+        }
+    };
+
+    // a log with room for capacity entries holding the first count of from,
+    // if given. may throw bad_alloc
+    static CompletionLog* newLog(int capacity, const CompletionLog* from);
+
+    static void deleteLog(CompletionLog* log);
+
+    int globalBonus = 0;
+    DynamicArray<int> awardPrefix; // awardPrefix[t - 1] is the bonus at time t
+
+    int bonusAt(int time) const;
+
+    DynamicArray<int> bonusPenalty; // to account for coming later than past bonuses
+    DynamicArray<int> completionPoints; // number of points student got by finishing courses.
+    DynamicArray<int> courseCnt; // courses enrolled in or waitlisted for
+    DynamicArray<Handle> nextFree; // free list link, only meaningful for free slots
+    DynamicArray<int> joinedAt; // time the student was added at
+    DynamicArray<CompletionLog*> completionLog; // null until the first completion
+
+    Handle freeHead = NO_SLOT;
+    std::size_t freeCnt = 0;
+
+public:
+
+    StudentStore() = default;
+
+    StudentStore(const StudentStore&) = delete;
+
+    StudentStore& operator=(const StudentStore&) = delete;
+
+    ~StudentStore();
+
+    // may throw bad_alloc, in which case the store is unchanged
+    void addToGlobalBonus(int points);
+
+    int getGlobalBonus() const;
+
+    int getCurrentTime() const;
+
+    // may throw bad_alloc, in which case the store is unchanged
+    Handle add();
+
+    // adds courseCnts.getSize() students at once, student i enrolled in or
+    // waitlisted for courseCnts[i] courses, in consecutive slots past the
+    // last one. returns the handle of the first. may throw bad_alloc, in
+    // which case the store is unchanged
+    Handle addBulk(const DynamicArray<int>& courseCnts);
+
+    // takes back the students addBulk returned first for, and every slot
+    // after them
+    void removeBulk(Handle first);
+
+    void remove(Handle student);
+
+    void enroll(Handle student);
+
+    void unenroll(Handle student);
+
+    // may throw bad_alloc, in which case the store is unchanged
+    void addCompletionPoints(Handle student, int points);
+
+    int getStudentPoints(Handle student) const;
+
+    int getJoinTime(Handle student) const;
+
+    // caller must ensure getJoinTime(student) <= time <= getCurrentTime()
+    int getStudentPointsAsOf(Handle student, int time) const;
+
+    bool hasAnyCourses(Handle student) const;
+
+    StudentRecord getRecord(Handle student) const;
+
+    TreeMemory memoryUsage() const;
+
+    // moves the field arrays and the award log into memory placed as asked,
+    // where they stay as they grow. the completion logs stay on the heap.
+    // may throw bad_alloc, and each array moves all or nothing, so the
+    // store stays whole either way
+    void setPlacement(const MemoryPlacement& placement);
+
+    // moves the live students to the front, dropping the free slots, and
+    // fills remap with the new handle of every old handle. may throw
+    // bad_alloc before anything changed
+    void compact(DynamicArray<Handle>& remap);
+
+};
+
+
+#endif //DS_WET_1_STUDENTSTORE_H
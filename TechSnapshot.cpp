@@ -0,0 +1,41 @@
+#include "TechSnapshot.h"
+
+TechSnapshot::TechSnapshot() : globalBonus(0)
+{
+}
+
+TechSnapshot::TechSnapshot(const PersistentAvlTree<int, StudentRecord>& students,
+                           const PersistentAvlTree<int, CourseRecord>& courses,
+                           const int globalBonus)
+    : students(students), courses(courses), globalBonus(globalBonus)
+{
+}
+
+int TechSnapshot::pointsOf(const StudentRecord& record) const
+{
+    return record.completionPoints + (globalBonus - record.bonusPenalty);
+}
+
+output_t<int> TechSnapshot::getStudentPoints(const int studentId) const
+{
+    if (studentId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    const StudentRecord* record = students.find(studentId);
+    if (record == nullptr) {
+        return StatusType::FAILURE;
+    }
+    return pointsOf(*record);
+}
+
+output_t<bool> TechSnapshot::isEnrolled(const int studentId, const int courseId) const
+{
+    if (studentId <= 0 || courseId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    const CourseRecord* course = courses.find(courseId);
+    if (course == nullptr) {
+        return StatusType::FAILURE;
+    }
+    return course->enrolledStudents.find(studentId) != nullptr;
+}
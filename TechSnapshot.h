@@ -0,0 +1,64 @@
+#ifndef DS_WET_1_TECHSNAPSHOT_H
+#define DS_WET_1_TECHSNAPSHOT_H
+
+#include "PersistentAvlTree.h"
+#include "StudentStore.h"
+#include "wet1util.h"
+
+struct CourseRecord
+{
+    int courseCredit;
+    PersistentAvlTree<int, bool> enrolledStudents; // set of student ids
+};
+
+// Immutable point-in-time view of a TechSystem. Taking one is O(1) once the
+// system has built the views it shares, and it stays valid and unchanged
+// while the system keeps being modified, so it can be handed to a reader on
+// another thread.
+class TechSnapshot
+{
+    PersistentAvlTree<int, StudentRecord> students;
+    PersistentAvlTree<int, CourseRecord> courses;
+    int globalBonus;
+
+    int pointsOf(const StudentRecord& record) const;
+
+public:
+
+    // an empty system
+    TechSnapshot();
+
+    TechSnapshot(const PersistentAvlTree<int, StudentRecord>& students,
+                 const PersistentAvlTree<int, CourseRecord>& courses,
+                 int globalBonus);
+
+    output_t<int> getStudentPoints(int studentId) const;
+
+    output_t<bool> isEnrolled(int studentId, int courseId) const;
+
+    // calls function(studentId, points) for every student in id order
+    template <typename Function>
+    void forEachStudent(Function function) const
+    {
+        students.forEach([this, &function](const int studentId,
+                                           const StudentRecord& record) {
+            function(studentId, pointsOf(record));
+        });
+    }
+
+    // calls function(courseId, studentId) for every enrollment in id order
+    template <typename Function>
+    void forEachEnrollment(Function function) const
+    {
+        courses.forEach([&function](const int courseId,
+                                    const CourseRecord& course) {
+            course.enrolledStudents.forEach([courseId, &function](
+                const int studentId, bool) {
+                function(courseId, studentId);
+            });
+        });
+    }
+};
+
+
+#endif //DS_WET_1_TECHSNAPSHOT_H
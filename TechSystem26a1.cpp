@@ -3,22 +3,337 @@
 
 #include "TechSystem26a1.h"
 
+#include <atomic>
 
 TechSystem::TechSystem() {
 }
 
 TechSystem::~TechSystem() {
+    // every course frees trees of its own, and so does every view node
+    // nothing else holds, so large ones are torn down on all cores. the
+    // student map has nothing to run per node and just gives its chunks back
+    const int threads = availableCores();
+    courseMap.clear(threads);
+    studentMap.clear(threads);
+    studentView.clear(threads);
+    courseView.clear(threads);
+}
+
+// index of id in the strictly increasing ids[0..count), or -1
+static int indexOf(const int* ids, const int count, const int id) {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        const int mid = low + (high - low) / 2;
+        if (ids[mid] < id) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low < count && ids[low] == id ? low : -1;
+}
+
+// ranges shorter than this are not worth a thread of their own
+static const int PARALLEL_GRAIN = 1 << 14;
+
+// fills the courses [begin, end), course i with the enrollments
+// [courseBegin[i], courseBegin[i + 1]). the range is halved by enrollment
+// count rather than by courses, so the threads get even shares of the work
+// however the enrollments are spread, and a course left alone on several
+// threads builds its tree on all of them
+static void loadCourses(const DynamicArray<Course*>& courses,
+                        const DynamicArray<int>& courseBegin,
+                        const int* enrollStudentIds,
+                        const DynamicArray<StudentStore::Handle>& handles,
+                        const int begin, const int end, const int threads) {
+    const int enrollments = courseBegin[end] - courseBegin[begin];
+    if (threads < 2 || end - begin < 2 || enrollments < 2 * PARALLEL_GRAIN) {
+        const int courseThreads = enrollments < 2 * PARALLEL_GRAIN ? 1 : threads;
+        for (int i = begin; i < end; i++) {
+            const int from = courseBegin[i];
+            const int count = courseBegin[i + 1] - from;
+            if (count > 0) {
+                courses[i]->assignEnrollments(enrollStudentIds + from,
+                                              &handles[from], count,
+                                              courseThreads);
+            }
+        }
+        return;
+    }
+    // split before the first course that starts past the middle enrollment,
+    // keeping at least one course on each side
+    const int middle = courseBegin[begin] + enrollments / 2;
+    int low = begin + 1;
+    int high = end - 1;
+    while (low < high) {
+        const int mid = low + (high - low) / 2;
+        if (courseBegin[mid] <= middle) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    auto loadFirst = [&]() {
+        loadCourses(courses, courseBegin, enrollStudentIds, handles, begin,
+                    low, threads / 2);
+    };
+    auto loadSecond = [&]() {
+        loadCourses(courses, courseBegin, enrollStudentIds, handles, low, end,
+                    threads - threads / 2);
+    };
+    forkJoin(loadFirst, loadSecond);
+}
+
+static bool isIncreasingIds(const int* ids, const int count) {
+    for (int i = 0; i < count; i++) {
+        if (ids[i] <= 0 || (i > 0 && ids[i] <= ids[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+StatusType TechSystem::bulkLoad(const int* studentIds, const int studentCount,
+                                const int* courseIds, const int* coursePoints,
+                                const int courseCount,
+                                const int* enrollCourseIds,
+                                const int* enrollStudentIds,
+                                const int enrollmentCount, const int threads) {
+    if (studentCount < 0 || courseCount < 0 || enrollmentCount < 0 ||
+        threads <= 0 || (studentCount > 0 && studentIds == nullptr) ||
+        (courseCount > 0 && (courseIds == nullptr || coursePoints == nullptr)) ||
+        (enrollmentCount > 0 &&
+         (enrollCourseIds == nullptr || enrollStudentIds == nullptr))) {
+        return StatusType::INVALID_INPUT;
+    }
+    if (!isIncreasingIds(studentIds, studentCount) ||
+        !isIncreasingIds(courseIds, courseCount)) {
+        return StatusType::INVALID_INPUT;
+    }
+    for (int i = 0; i < courseCount; i++) {
+        if (coursePoints[i] <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+    }
+    for (int i = 0; i < enrollmentCount; i++) {
+        // sorted by course, then by student
+        if (enrollCourseIds[i] <= 0 || enrollStudentIds[i] <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        if (i > 0 && (enrollCourseIds[i] < enrollCourseIds[i - 1] ||
+                      (enrollCourseIds[i] == enrollCourseIds[i - 1] &&
+                       enrollStudentIds[i] <= enrollStudentIds[i - 1]))) {
+            return StatusType::INVALID_INPUT;
+        }
+    }
+    if (!studentMap.isEmpty() || !courseMap.isEmpty()) {
+        return StatusType::FAILURE;
+    }
+
+    // courses are resolved to the range of enrollments they own, serially:
+    // it is one comparison per enrollment
+    DynamicArray<int> courseBegin;
+    DynamicArray<StudentStore::Handle> enrolledHandles;
+    DynamicArray<int> courseCnt;
+    try {
+        courseBegin.reserve(courseCount + 1);
+        enrolledHandles.resize(enrollmentCount);
+        courseCnt.resize(studentCount);
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
+    int next = 0;
+    for (int course = 0; course < courseCount; course++) {
+        courseBegin.pushBack(next);
+        while (next < enrollmentCount &&
+               enrollCourseIds[next] == courseIds[course]) {
+            next++;
+        }
+    }
+    courseBegin.pushBack(next);
+    if (next != enrollmentCount) {
+        // an enrollment names a course that is not loaded
+        return StatusType::FAILURE;
+    }
+
+    // every enrollment is resolved to its student's index in studentIds,
+    // which later becomes its handle, and counted towards that student
+    parallelFor(0, studentCount, threads, PARALLEL_GRAIN,
+                [&courseCnt](const int begin, const int end) {
+        for (int i = begin; i < end; i++) {
+            courseCnt[i] = 0;
+        }
+    });
+    std::atomic<bool> unknownStudent(false);
+    parallelFor(0, enrollmentCount, threads, PARALLEL_GRAIN,
+                [&](const int begin, const int end) {
+        for (int i = begin; i < end; i++) {
+            const int student =
+                indexOf(studentIds, studentCount, enrollStudentIds[i]);
+            if (student < 0) {
+                unknownStudent.store(true, std::memory_order_relaxed);
+                return;
+            }
+            enrolledHandles[i] = static_cast<StudentStore::Handle>(student);
+            __atomic_fetch_add(&courseCnt[student], 1, __ATOMIC_RELAXED);
+        }
+    });
+    if (unknownStudent.load()) {
+        return StatusType::FAILURE;
+    }
+
+    bool added = false;
+    StudentStore::Handle first = 0;
+    try {
+        first = students.addBulk(courseCnt);
+        added = true;
+        parallelFor(0, enrollmentCount, threads, PARALLEL_GRAIN,
+                    [&enrolledHandles, first](const int begin, const int end) {
+            for (int i = begin; i < end; i++) {
+                enrolledHandles[i] += first;
+            }
+        });
+
+        studentMap.assignSorted(
+            studentCount, [studentIds](const int i) { return studentIds[i]; },
+            [first](const int i) {
+                return static_cast<StudentStore::Handle>(first + i);
+            },
+            threads);
+        courseMap.assignSorted(
+            courseCount, [courseIds](const int i) { return courseIds[i]; },
+            [coursePoints](const int i) { return Course(coursePoints[i]); },
+            threads);
+        // no map changes until the courses are filled, so they can be held
+        // by address
+        DynamicArray<Course*> courses;
+        courses.reserve(courseCount);
+        courseMap.forEachValue([&courses](Course& course) {
+            courses.pushBack(&course);
+        });
+        loadCourses(courses, courseBegin, enrollStudentIds, enrolledHandles,
+                    0, courseCount, threads);
+
+        totalEnrollments = enrollmentCount;
+        // views of the empty system, if a snapshot built them
+        dropViews();
+    }
+    catch (const std::bad_alloc&) {
+        courseMap.clear(threads);
+        studentMap.clear(threads);
+        if (added) {
+            students.removeBulk(first);
+        }
+        return StatusType::ALLOCATION_ERROR;
+    }
+    return StatusType::SUCCESS;
+}
+
+void TechSystem::buildViews() {
+    DynamicArray<int> ids;
+    DynamicArray<StudentRecord> records;
+    studentMap.forEach([&](const int studentId,
+                           const StudentStore::Handle student) {
+        ids.reserveNext();
+        records.reserveNext();
+        ids.pushBack(studentId);
+        records.pushBack(students.getRecord(student));
+    });
+    PersistentAvlTree<int, StudentRecord> nextStudentView;
+    nextStudentView.assignSorted(
+        static_cast<int>(ids.getSize()),
+        [&ids](const int i) { return ids[i]; },
+        [&records](const int i) { return records[i]; });
+
+    // no map changes until the views are built, so the courses can be
+    // held by address
+    ids.truncate(0);
+    DynamicArray<const Course*> courses;
+    courseMap.forEach([&](const int courseId, const Course& course) {
+        ids.reserveNext();
+        courses.reserveNext();
+        ids.pushBack(courseId);
+        courses.pushBack(&course);
+    });
+    DynamicArray<int> enrolled;
+    PersistentAvlTree<int, CourseRecord> nextCourseView;
+    nextCourseView.assignSorted(
+        static_cast<int>(ids.getSize()),
+        [&ids](const int i) { return ids[i]; },
+        [&](const int i) {
+            enrolled.truncate(0);
+            courses[i]->forEachEnrolled([&enrolled](const int studentId) {
+                enrolled.reserveNext();
+                enrolled.pushBack(studentId);
+            });
+            CourseRecord record{courses[i]->getCredit(), {}};
+            record.enrolledStudents.assignSorted(
+                static_cast<int>(enrolled.getSize()),
+                [&enrolled](const int j) { return enrolled[j]; },
+                [](int) { return true; });
+            return record;
+        });
+
+    studentView = std::move(nextStudentView);
+    courseView = std::move(nextCourseView);
+    viewsBuilt = true;
+}
+
+// Every mutation changes the maps first and then brings the views along, if
+// they are built. A view update that runs out of memory drops the views
+// rather than failing a mutation that already happened.
+
+template <typename Update>
+void TechSystem::updateViews(const Update& update) {
+    if (!viewsBuilt) {
+        return;
+    }
+    try {
+        update();
+    }
+    catch (const std::bad_alloc&) {
+        dropViews();
+    }
+}
+
+void TechSystem::dropViews() {
+    studentView = PersistentAvlTree<int, StudentRecord>();
+    courseView = PersistentAvlTree<int, CourseRecord>();
+    viewsBuilt = false;
+}
+
+void TechSystem::seatInView(const int courseId, const int studentId,
+                            const int promoted) {
+    CourseRecord* courseRecord = courseView.findForUpdate(courseId);
+    courseRecord->enrolledStudents.erase(studentId);
+    if (promoted != 0) {
+        courseRecord->enrolledStudents.assign(promoted, true);
+    }
 }
 
 StatusType TechSystem::addStudent(const int studentId) {
     if (studentId <= 0) {
         return StatusType::INVALID_INPUT;
     }
+    if (studentMap.find(studentId) != nullptr) {
+        return StatusType::FAILURE;
+    }
     try {
-        const bool hasInserted = studentMap.insert(studentId, {});
-        if (!hasInserted) {
-            return StatusType::FAILURE;
+        const StudentStore::Handle student = students.add();
+        try {
+            studentMap.insert(studentId, student);
+        }
+        catch (const std::bad_alloc&) {
+            students.remove(student);
+            throw;
         }
+        updateViews([&] {
+            studentView.assign(studentId, students.getRecord(student));
+        });
     }
     catch (const std::bad_alloc&) {
         return StatusType::ALLOCATION_ERROR;
@@ -31,10 +346,14 @@ StatusType TechSystem::removeStudent(int studentId) {
         return StatusType::INVALID_INPUT;
     }
     auto* toRemove = studentMap.find(studentId);
-    if (toRemove == nullptr || toRemove->getValue().hasAnyCourses()) {
+    if (toRemove == nullptr || students.hasAnyCourses(toRemove->getValue())) {
         return StatusType::FAILURE;
     }
+    students.remove(toRemove->getValue());
     studentMap.erase(toRemove);
+    updateViews([&] {
+        studentView.erase(studentId);
+    });
     return StatusType::SUCCESS;
 }
 
@@ -48,6 +367,9 @@ StatusType TechSystem::addCourse(int courseId, int points) {
             // already in map
             return StatusType::FAILURE;
         }
+        updateViews([&] {
+            courseView.assign(courseId, CourseRecord{points, {}});
+        });
     }
     catch (const std::bad_alloc&) {
         return StatusType::ALLOCATION_ERROR;
@@ -64,6 +386,9 @@ StatusType TechSystem::removeCourse(int courseId) {
         return StatusType::FAILURE;
     }
     courseMap.erase(toRemove);
+    updateViews([&] {
+        courseView.erase(courseId);
+    });
     return StatusType::SUCCESS;
 }
 
@@ -77,11 +402,22 @@ StatusType TechSystem::enrollStudent(int studentId, int courseId) {
         return StatusType::FAILURE;
     }
     // course is in course map
+    Course& course = courseN->getValue();
+    if (course.isEnrolled(studentId) ||
+        course.getWaitlistPosition(studentId) != 0) {
+        return StatusType::FAILURE;
+    }
 
     try {
-        const bool hasInserted = courseN->getValue().enroll(studentId, studentN->getValue());
-        if (!hasInserted) {
-            return StatusType::FAILURE;
+        // a full course waitlists the student instead
+        const bool seated = course.hasFreeSeat();
+        course.enroll(studentId, studentN->getValue(), students);
+        if (seated) {
+            totalEnrollments++;
+            updateViews([&] {
+                courseView.findForUpdate(courseId)->enrolledStudents.assign(
+                    studentId, true);
+            });
         }
     }
     catch (const std::bad_alloc&) {
@@ -99,10 +435,28 @@ StatusType TechSystem::completeCourse(int studentId, int courseId) {
     if (courseN == nullptr) {
         return StatusType::FAILURE;
     }
-    bool hasCompleted = courseN->getValue().complete(studentId);
-    if (!hasCompleted) {
+    Course& course = courseN->getValue();
+    if (!course.isEnrolled(studentId)) {
         return StatusType::FAILURE;
     }
+
+    try {
+        const int promoted = course.nextInLine();
+        course.complete(studentId, students);
+        if (promoted == 0) {
+            totalEnrollments--;
+        }
+        totalCreditsAwarded += course.getCredit();
+        updateViews([&] {
+            // an enrolled student is always in the student map
+            studentView.assign(studentId, students.getRecord(
+                studentMap.find(studentId)->getValue()));
+            seatInView(courseId, studentId, promoted);
+        });
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
     return StatusType::SUCCESS;
 }
 
@@ -110,7 +464,12 @@ StatusType TechSystem::awardAcademicPoints(int points) {
     if (points <= 0) {
         return StatusType::INVALID_INPUT;
     }
-    Student::addToGlobalBonus(points);
+    try {
+        students.addToGlobalBonus(points);
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
     return StatusType::SUCCESS;
 }
 
@@ -122,5 +481,200 @@ output_t<int> TechSystem::getStudentPoints(int studentId) {
     if (studentN == nullptr) {
         return StatusType::FAILURE;
     }
-    return studentN->getValue().getStudentPoints();
+    return students.getStudentPoints(studentN->getValue());
+}
+
+output_t<TechSnapshot> TechSystem::snapshot() {
+    if (!viewsBuilt) {
+        try {
+            buildViews();
+        }
+        catch (const std::bad_alloc&) {
+            return StatusType::ALLOCATION_ERROR;
+        }
+    }
+    return TechSnapshot(studentView, courseView, students.getGlobalBonus());
+}
+
+output_t<CourseStats> TechSystem::getCourseStats(int courseId) const {
+    if (courseId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    auto* courseN = courseMap.find(courseId);
+    if (courseN == nullptr) {
+        return StatusType::FAILURE;
+    }
+    return courseN->getValue().getStats();
+}
+
+output_t<int> TechSystem::getTotalEnrollments() const {
+    return totalEnrollments;
+}
+
+output_t<long long> TechSystem::getTotalCreditsAwarded() const {
+    return totalCreditsAwarded;
+}
+
+output_t<int> TechSystem::getCurrentTime() const {
+    return students.getCurrentTime();
+}
+
+output_t<int> TechSystem::getStudentPointsAsOf(int studentId, int time) const {
+    if (studentId <= 0 || time < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    auto* studentN = studentMap.find(studentId);
+    if (studentN == nullptr || time > students.getCurrentTime()) {
+        return StatusType::FAILURE;
+    }
+    const StudentStore::Handle student = studentN->getValue();
+    if (time < students.getJoinTime(student)) {
+        // the student did not exist yet
+        return StatusType::FAILURE;
+    }
+    return students.getStudentPointsAsOf(student, time);
+}
+
+StatusType TechSystem::setCourseCapacity(int courseId, int capacity) {
+    if (courseId <= 0 || capacity <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    auto* courseN = courseMap.find(courseId);
+    if (courseN == nullptr) {
+        return StatusType::FAILURE;
+    }
+    Course& course = courseN->getValue();
+
+    try {
+        const int seated = course.seatsOpenedBy(capacity);
+        // the students to seat, read while they are still on the waitlist
+        DynamicArray<int> seatedIds;
+        if (viewsBuilt) {
+            seatedIds.reserve(seated);
+            for (int position = 1; position <= seated; position++) {
+                seatedIds.pushBack(course.getWaitlisted(position));
+            }
+        }
+
+        course.setCapacity(capacity);
+        totalEnrollments += seated;
+        updateViews([&] {
+            CourseRecord* courseRecord = courseView.findForUpdate(courseId);
+            for (std::size_t i = 0; i < seatedIds.getSize(); i++) {
+                courseRecord->enrolledStudents.assign(seatedIds[i], true);
+            }
+        });
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
+    return StatusType::SUCCESS;
+}
+
+StatusType TechSystem::withdrawStudent(int studentId, int courseId) {
+    if (studentId <= 0 || courseId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    auto* courseN = courseMap.find(courseId);
+    if (courseN == nullptr) {
+        return StatusType::FAILURE;
+    }
+    Course& course = courseN->getValue();
+    const bool seated = course.isEnrolled(studentId);
+    if (!seated && course.getWaitlistPosition(studentId) == 0) {
+        return StatusType::FAILURE;
+    }
+
+    try {
+        const int promoted = seated ? course.nextInLine() : 0;
+        course.withdraw(studentId, students);
+        if (seated && promoted == 0) {
+            totalEnrollments--;
+        }
+        if (seated) {
+            updateViews([&] {
+                seatInView(courseId, studentId, promoted);
+            });
+        }
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
+    return StatusType::SUCCESS;
+}
+
+output_t<int> TechSystem::getWaitlistPosition(int studentId, int courseId) const {
+    if (studentId <= 0 || courseId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    auto* courseN = courseMap.find(courseId);
+    if (courseN == nullptr) {
+        return StatusType::FAILURE;
+    }
+    const int position = courseN->getValue().getWaitlistPosition(studentId);
+    if (position == 0) {
+        return StatusType::FAILURE;
+    }
+    return position;
+}
+
+MemoryUsage TechSystem::memoryUsage() const {
+    MemoryUsage usage;
+    usage.studentMap = studentMap.memoryUsage();
+    usage.courseMap = courseMap.memoryUsage();
+    courseMap.forEachValue([&usage](const Course& course) {
+        usage.enrollmentTrees += course.memoryUsage();
+    });
+    usage.studentStore = students.memoryUsage();
+    usage.snapshotViews = studentView.memoryUsage();
+    usage.snapshotViews += courseView.memoryUsage();
+    courseView.forEach([&usage](int, const CourseRecord& course) {
+        usage.snapshotViews += course.enrolledStudents.memoryUsage();
+    });
+    return usage;
+}
+
+StatusType TechSystem::compact() {
+    try {
+        // renumbering the students fails, if at all, before anything moved
+        DynamicArray<StudentStore::Handle> remap;
+        students.compact(remap);
+        studentMap.forEachValue([&remap](StudentStore::Handle& student) {
+            student = remap[student];
+        });
+        courseMap.forEachValue([&remap](Course& course) {
+            course.remapStudents(remap);
+        });
+
+        // snapshots already taken keep their own references
+        dropViews();
+
+        // each tree compacts all or nothing, so stopping halfway is safe
+        studentMap.compact();
+        courseMap.compact();
+        courseMap.forEachValue([](Course& course) {
+            course.compact();
+        });
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
+    return StatusType::SUCCESS;
+}
+
+StatusType TechSystem::setMemoryPlacement(const MemoryPlacement& placement) {
+    if (placement.numaNode < -1) {
+        return StatusType::INVALID_INPUT;
+    }
+    try {
+        // each map and array moves all or nothing, so stopping halfway is
+        // safe
+        studentMap.setPlacement(placement);
+        courseMap.setPlacement(placement);
+        students.setPlacement(placement);
+    }
+    catch (const std::bad_alloc&) {
+        return StatusType::ALLOCATION_ERROR;
+    }
+    return StatusType::SUCCESS;
 }
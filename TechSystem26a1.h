@@ -14,15 +14,59 @@
 #define TechSystem26WINTER_WET1_H_
 
 #include "Course.h"
-#include "Student.h"
+#include "StudentStore.h"
+#include "TechSnapshot.h"
 
 #include "wet1util.h"
 #include "AvlTree.h"
+#include "TechSystemBackend.h"
+
+struct MemoryUsage {
+    TreeMemory studentMap;
+    TreeMemory courseMap; // includes the Course objects themselves
+    TreeMemory enrollmentTrees; // all courses together
+    TreeMemory studentStore;
+    // both views and the enrollment sets inside them, zero until the first
+    // snapshot builds them. nodes the views share with snapshots still
+    // held are counted here, as they are kept alive on their behalf too
+    TreeMemory snapshotViews;
+};
 
 class TechSystem {
 
-    AvlTree<int, Student> studentMap;
-    AvlTree<int, Course> courseMap;
+    StudentStore students;
+
+    // AvlTree or BTree, see TechSystemBackend.h. no map handle is kept
+    // across operations, as BTree ones die on the next insert or erase
+    OrderedMap<int, StudentStore::Handle> studentMap;
+    OrderedMap<int, Course> courseMap;
+
+    // persistent copies of the student and course data for snapshot() to
+    // share in O(1). built by the first snapshot and kept in step with the
+    // maps from then on, so a system that never takes one never pays for
+    // them. they are only a cache: when updating them runs out of memory
+    // they are dropped, and the next snapshot builds them again
+    PersistentAvlTree<int, StudentRecord> studentView;
+    PersistentAvlTree<int, CourseRecord> courseView;
+    bool viewsBuilt = false;
+
+    // may throw bad_alloc, in which case the views stay unbuilt
+    void buildViews();
+
+    // applies update to the views if they are built, dropping them if it
+    // throws bad_alloc
+    template <typename Update>
+    void updateViews(const Update& update);
+
+    void dropViews();
+
+    // takes studentId out of the course's view, seating promoted, if not 0,
+    // in its place. may throw bad_alloc
+    void seatInView(int courseId, int studentId, int promoted);
+
+    // system-wide rollups, kept up to date by every mutation
+    int totalEnrollments = 0; // currently active enrollments
+    long long totalCreditsAwarded = 0; // credits of all completed courses
 
 
 public:
@@ -48,6 +92,69 @@ public:
     output_t<int> getStudentPoints(int studentId);
 
     // } </DO-NOT-MODIFY>
+
+    // the state of the system now, to be read on any thread while the
+    // system keeps changing. O(1), except for the first one, which builds
+    // the views it shares in O(n)
+    output_t<TechSnapshot> snapshot();
+
+    // Fills an empty system from id-sorted input: students and courses by
+    // id, enrollments by course id and then student id. Every tree is built
+    // in O(n) on up to threads threads: AvlTrees balanced, a disjoint
+    // subtree per thread, and BTree id maps with all but full leaves, a
+    // disjoint range of leaves per thread.
+    StatusType bulkLoad(const int* studentIds, int studentCount,
+                        const int* courseIds, const int* coursePoints,
+                        int courseCount, const int* enrollCourseIds,
+                        const int* enrollStudentIds, int enrollmentCount,
+                        int threads);
+
+    output_t<CourseStats> getCourseStats(int courseId) const;
+
+    output_t<int> getTotalEnrollments() const;
+
+    output_t<long long> getTotalCreditsAwarded() const;
+
+    // Time counts awards: time t is the state after the t-th call to
+    // awardAcademicPoints and before the next one, so the current time is
+    // the number of awards so far.
+    output_t<int> getCurrentTime() const;
+
+    // points of a current student as of a past time at or after it was added
+    output_t<int> getStudentPointsAsOf(int studentId, int time) const;
+
+    // Limits a course to capacity seats. Once a course is full,
+    // enrollStudent puts students on its waitlist, first come first served,
+    // and a seat freed by completeCourse or withdrawStudent goes to the
+    // first in line. Raising the limit seats waitlisted students at once.
+    StatusType setCourseCapacity(int courseId, int capacity);
+
+    // takes a student out of a course, or off its waitlist, with no credit
+    StatusType withdrawStudent(int studentId, int courseId);
+
+    // 1 for the first in line. FAILURE if not waiting for the course
+    output_t<int> getWaitlistPosition(int studentId, int courseId) const;
+
+    // bytes held by each tree, walks every course and the snapshot views
+    MemoryUsage memoryUsage() const;
+
+    // Moves every tree into a single dense block and renumbers the student
+    // slots to close the holes left by removed students, returning freed
+    // memory to the heap. The snapshot views are dropped rather than
+    // compacted: the next snapshot builds them afresh, balanced and without
+    // the copies left behind by earlier ones. BTree maps have nothing to
+    // compact and are left as they are. Takes O(n), meant for quiet hours.
+    StatusType compact();
+
+    // Moves the student and course maps and the field arrays of the
+    // student store into memory placed as asked, and keeps them there as
+    // they grow: 2 MB aligned regions that transparent huge pages back (or
+    // are kept off), optionally bound to one NUMA node, so that a system
+    // serving as one socket's shard keeps its data local. The small
+    // per-course trees, the students' completion logs and the snapshot
+    // views stay on the heap, and so do BTree maps, which ignore placement.
+    // ALLOCATION_ERROR if the memory can't be mapped or bound. Takes O(n).
+    StatusType setMemoryPlacement(const MemoryPlacement& placement);
 };
 
 #endif // TechSystem26WINTER_WET1_H_
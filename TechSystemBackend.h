@@ -0,0 +1,23 @@
+#pragma once
+
+#include "AvlTree.h"
+#include "BTree.h"
+
+// Ordered map behind TechSystem's student and course maps: AvlTree, or
+// BTree when TECH_SYSTEM_BTREE is defined. The define has to be the same in
+// every translation unit that includes TechSystem26a1.h, which the build
+// sees to by setting it on the library itself. Both share the
+// find/insert/erase/assignSorted/forEach surface, but a BTree map differs:
+// - a handle from find(), and any pointer into its value, is only good
+//   until the next insert or erase on the same map, as entries live inline
+//   in leaves that split and merge. AvlTree handles last until their own
+//   erase
+// - setPlacement is ignored, its nodes always come from the heap
+// - compact does nothing, nodes are kept half full and freed ones reused
+// - there is no size()
+template <typename KeyType, typename ValueType>
+#ifdef TECH_SYSTEM_BTREE
+using OrderedMap = BTree<KeyType, ValueType>;
+#else
+using OrderedMap = AvlTree<KeyType, ValueType>;
+#endif
@@ -0,0 +1,185 @@
+#include "Waitlist.h"
+
+#include <utility>
+
+const int Waitlist::LEFT;
+
+// the lowest set bit of i, the span a Fenwick tree entry sums over
+static std::size_t lowBit(const std::size_t i)
+{
+    return i & (~i + 1);
+}
+
+Waitlist::Waitlist(const Waitlist& other)
+    : tickets(other.tickets), waiting(other.waiting)
+{
+    const std::size_t used = other.studentIds.getSize();
+    studentIds.reserve(used);
+    handles.reserve(used);
+    counts.reserve(used);
+    for (std::size_t i = 0; i < used; i++) {
+        studentIds.pushBack(other.studentIds[i]);
+        handles.pushBack(other.handles[i]);
+        counts.pushBack(other.counts[i]);
+    }
+}
+
+Waitlist::Waitlist(Waitlist&& other) noexcept
+    : tickets(std::move(other.tickets)), waiting(other.waiting)
+{
+    studentIds.swap(other.studentIds);
+    handles.swap(other.handles);
+    counts.swap(other.counts);
+    other.waiting = 0;
+}
+
+int Waitlist::prefixCount(const std::size_t end) const
+{
+    // entry i - 1 sums tickets [i - lowBit(i), i)
+    int count = 0;
+    for (std::size_t i = end; i > 0; i -= lowBit(i)) {
+        count += counts[i - 1];
+    }
+    return count;
+}
+
+std::size_t Waitlist::ticketAt(int position) const
+{
+    const std::size_t used = counts.getSize();
+    std::size_t step = 1;
+    while (step * 2 <= used) {
+        step *= 2;
+    }
+    // largest end with prefixCount(end) < position, which is the ticket
+    std::size_t end = 0;
+    for (; step > 0; step /= 2) {
+        if (end + step <= used && counts[end + step - 1] < position) {
+            end += step;
+            position -= counts[end - 1];
+        }
+    }
+    return end;
+}
+
+void Waitlist::renumber(const std::size_t capacity)
+{
+    const std::size_t used = studentIds.getSize();
+    DynamicArray<int> newStudentIds;
+    DynamicArray<StudentStore::Handle> newHandles;
+    DynamicArray<int> newCounts;
+    DynamicArray<std::size_t> newTicket;
+    newStudentIds.reserve(capacity);
+    newHandles.reserve(capacity);
+    newCounts.reserve(capacity);
+    newTicket.reserve(used);
+
+    for (std::size_t ticket = 0; ticket < used; ticket++) {
+        newTicket.pushBack(newStudentIds.getSize());
+        if (studentIds[ticket] != LEFT) {
+            newStudentIds.pushBack(studentIds[ticket]);
+            newHandles.pushBack(handles[ticket]);
+            newCounts.pushBack(1);
+        }
+    }
+    // builds the Fenwick tree in O(n): each entry adds itself to the next
+    // entry whose span covers it
+    for (std::size_t i = 1; i <= newCounts.getSize(); i++) {
+        const std::size_t parent = i + lowBit(i);
+        if (parent <= newCounts.getSize()) {
+            newCounts[parent - 1] += newCounts[i - 1];
+        }
+    }
+
+    tickets.forEachValue([&newTicket](std::size_t& ticket) {
+        ticket = newTicket[ticket];
+    });
+    studentIds.swap(newStudentIds);
+    handles.swap(newHandles);
+    counts.swap(newCounts);
+}
+
+void Waitlist::push(const int studentId, const StudentStore::Handle student)
+{
+    const std::size_t used = studentIds.getSize();
+    if (used == studentIds.getCapacity() && used >= 2 * static_cast<std::size_t>(waiting) + 16) {
+        // full, and at least half the tickets are of students that left
+        renumber(used);
+    }
+    studentIds.reserveNext();
+    handles.reserveNext();
+    counts.reserveNext();
+
+    const std::size_t ticket = studentIds.getSize();
+    tickets.insert(studentId, ticket);
+    // entry ticket sums tickets [end - lowBit(end), end) with end = ticket + 1
+    const std::size_t end = ticket + 1;
+    counts.pushBack(1 + prefixCount(ticket) - prefixCount(end - lowBit(end)));
+    studentIds.pushBack(studentId);
+    handles.pushBack(student);
+    waiting++;
+}
+
+bool Waitlist::remove(const int studentId, StudentStore::Handle& student)
+{
+    auto* node = tickets.find(studentId);
+    if (node == nullptr) {
+        return false;
+    }
+    const std::size_t ticket = node->getValue();
+    student = handles[ticket];
+    for (std::size_t i = ticket + 1; i <= counts.getSize(); i += lowBit(i)) {
+        counts[i - 1]--;
+    }
+    studentIds[ticket] = LEFT;
+    tickets.erase(node);
+    waiting--;
+    return true;
+}
+
+int Waitlist::getPosition(const int studentId) const
+{
+    auto* node = tickets.find(studentId);
+    if (node == nullptr) {
+        return 0;
+    }
+    return prefixCount(node->getValue() + 1);
+}
+
+int Waitlist::studentAt(const int position) const
+{
+    return studentIds[ticketAt(position)];
+}
+
+StudentStore::Handle Waitlist::handleAt(const int position) const
+{
+    return handles[ticketAt(position)];
+}
+
+int Waitlist::getSize() const
+{
+    return waiting;
+}
+
+TreeMemory Waitlist::memoryUsage() const
+{
+    const std::size_t rowBytes = 2 * sizeof(int) + sizeof(StudentStore::Handle);
+    TreeMemory usage = tickets.memoryUsage();
+    usage.liveBytes += waiting * rowBytes;
+    usage.reservedBytes += studentIds.getCapacity() * rowBytes;
+    return usage;
+}
+
+void Waitlist::compact()
+{
+    renumber(waiting);
+    tickets.compact();
+}
+
+void Waitlist::remapStudents(const DynamicArray<StudentStore::Handle>& remap)
+{
+    for (std::size_t ticket = 0; ticket < studentIds.getSize(); ticket++) {
+        if (studentIds[ticket] != LEFT) {
+            handles[ticket] = remap[handles[ticket]];
+        }
+    }
+}
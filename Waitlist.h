@@ -0,0 +1,73 @@
+#ifndef DS_WET_1_WAITLIST_H
+#define DS_WET_1_WAITLIST_H
+
+#include <cstddef>
+
+#include "AvlTree.h"
+#include "DynamicArray.h"
+#include "StudentStore.h"
+
+// Students waiting for a seat in one course, first come first served.
+// Every arrival takes the next ticket, and a Fenwick tree over the tickets
+// counts the ones still waiting. That makes it an order-statistic index: a
+// student's position is a prefix count and the student at a position is
+// found by descending the tree, both O(log n). Tickets of students that
+// left are dropped by renumbering once they make up half the tickets.
+class Waitlist
+{
+    static const int LEFT = 0; // student id of a ticket whose student left
+
+    DynamicArray<int> studentIds; // by ticket
+    DynamicArray<StudentStore::Handle> handles; // by ticket
+    DynamicArray<int> counts; // Fenwick tree of waiting students by ticket
+    AvlTree<int, std::size_t> tickets; // ticket of every waiting student
+    int waiting = 0;
+
+    // waiting students among tickets [0, end)
+    int prefixCount(std::size_t end) const;
+
+    std::size_t ticketAt(int position) const;
+
+    // moves the waiting students to tickets [0, waiting) of arrays holding
+    // capacity tickets. may throw bad_alloc, in which case nothing changed
+    void renumber(std::size_t capacity);
+
+public:
+
+    Waitlist() = default;
+
+    // may throw bad_alloc
+    Waitlist(const Waitlist& other);
+
+    Waitlist(Waitlist&& other) noexcept;
+
+    Waitlist& operator=(const Waitlist&) = delete;
+
+    // puts a student who isn't waiting yet at the end of the line. may
+    // throw bad_alloc, in which case the waitlist is unchanged
+    void push(int studentId, StudentStore::Handle student);
+
+    // takes a student out of line. false if they weren't waiting
+    bool remove(int studentId, StudentStore::Handle& student);
+
+    // 1 for the first in line, 0 if the student isn't waiting
+    int getPosition(int studentId) const;
+
+    // caller must ensure 1 <= position <= getSize()
+    int studentAt(int position) const;
+
+    StudentStore::Handle handleAt(int position) const;
+
+    int getSize() const;
+
+    TreeMemory memoryUsage() const;
+
+    // may throw bad_alloc, in which case the waitlist is unchanged
+    void compact();
+
+    // replaces every student handle h by remap[h]
+    void remapStudents(const DynamicArray<StudentStore::Handle>& remap);
+};
+
+
+#endif //DS_WET_1_WAITLIST_H
@@ -0,0 +1,486 @@
+// Differential stress of AvlTree<int, int> and BTree<int, int> against
+// std::map.
+//
+// The tree under test is AvlTree<int, int, AvlTreeAudit>, so every rotation,
+// swap and rebalance of the tree checks the subtree it touched while
+// AvlTreeAudit::enabled is set. BTree has no hook, its audited pass checks
+// the whole tree after each operation instead.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "AvlTree.h"
+#include "BTree.h"
+#include "Stress.h"
+
+// the first broken invariant an audit found
+struct AuditFailure {
+    static bool failed;
+    static char failure[256];
+
+    template <typename... Args>
+    static void fail(const char* format, Args... args) {
+        if (!failed) {
+            failed = true;
+            std::snprintf(failure, sizeof(failure), format, args...);
+        }
+    }
+};
+
+bool AuditFailure::failed = false;
+char AuditFailure::failure[256];
+
+struct AvlTreeAudit : AuditFailure {
+    static bool enabled;
+
+    // checks the subtree of node and returns its height. keys must lie in
+    // (low, high) when ordered, and balance factors in [-1, 1] when balanced
+    template <typename Node>
+    static int verify(const Node* node, const Node* parent, const int* low,
+                      const int* high, const bool ordered, const bool balanced,
+                      const char* event) {
+        if (node == nullptr) {
+            return -1;
+        }
+        if (node->parent != parent) {
+            fail("%s: node %d has a wrong parent link", event, node->key);
+        }
+        if (ordered && ((low != nullptr && !(*low < node->key)) ||
+                        (high != nullptr && !(node->key < *high)))) {
+            fail("%s: node %d is out of key order", event, node->key);
+        }
+        const int left = verify(node->left, node, low, &node->key, ordered,
+                                balanced, event);
+        const int right = verify(node->right, node, &node->key, high, ordered,
+                                 balanced, event);
+        const int height = (left > right ? left : right) + 1;
+        if (node->height != height) {
+            fail("%s: node %d has height %d, should be %d", event, node->key,
+                 node->height, height);
+        }
+        if (balanced && (left - right > 1 || right - left > 1)) {
+            fail("%s: node %d has balance factor %d", event, node->key,
+                 left - right);
+        }
+        return height;
+    }
+
+    // called by the tree as its audit policy. node is the root of the subtree that
+    // changed. a single rotation may leave it unbalanced halfway through a
+    // double rotation, and a swap leaves the node being erased out of order
+    template <typename Tree, typename Node>
+    static void check(const Tree& tree, const char* event, const Node* node) {
+        if (!enabled) {
+            return;
+        }
+        if (node->parent == nullptr ? tree.root != node
+                                    : node->parent->left != node &&
+                                      node->parent->right != node) {
+            fail("%s: node %d is not a child of its parent", event, node->key);
+        }
+        const bool isSwap = std::strcmp(event, "swap") == 0;
+        const bool isRebalance = std::strcmp(event, "rebalance") == 0;
+        verify(node, node->parent, nullptr, nullptr, !isSwap, isRebalance,
+               event);
+    }
+
+    template <typename Tree>
+    static void checkTree(const Tree& tree) {
+        verify(tree.root, decltype(tree.root)(nullptr), nullptr, nullptr, true,
+               true, "tree");
+    }
+
+    template <typename Tree>
+    static int height(const Tree& tree) {
+        return tree.root == nullptr ? -1 : tree.root->height;
+    }
+
+    template <typename Node>
+    static void collect(const Node* node, std::vector<std::pair<int, int>>& out) {
+        if (node != nullptr) {
+            collect(node->left, out);
+            out.emplace_back(node->key, node->value);
+            collect(node->right, out);
+        }
+    }
+
+    template <typename Tree>
+    static std::vector<std::pair<int, int>> contents(const Tree& tree) {
+        std::vector<std::pair<int, int>> out;
+        collect(tree.root, out);
+        return out;
+    }
+};
+
+bool AvlTreeAudit::enabled = false;
+
+struct BTreeAudit : AuditFailure {
+    // checks the subtree of node, whose keys must lie in [low, high), and
+    // returns its depth. every node but the root holds MIN_KEYS..CAPACITY
+    // keys in increasing order, and sits on a cache line of its own
+    template <typename Tree>
+    static int verify(typename Tree::Node* node, const int* low,
+                      const int* high, const bool isRoot) {
+        if (reinterpret_cast<std::uintptr_t>(node) % 64 != 0) {
+            fail("node %p is not cache line aligned", static_cast<void*>(node));
+        }
+        const int minimum = isRoot ? 1 : Tree::MIN_KEYS;
+        if (node->count < minimum || node->count > Tree::CAPACITY) {
+            fail("node of %d has %d keys", node->keys[0], node->count);
+        }
+        for (int i = 0; i < node->count; i++) {
+            if ((i > 0 && !(node->keys[i - 1] < node->keys[i])) ||
+                (low != nullptr && node->keys[i] < *low) ||
+                (high != nullptr && !(node->keys[i] < *high))) {
+                fail("key %d is out of order", node->keys[i]);
+            }
+        }
+        if (node->isLeaf) {
+            auto* entries = Tree::asLeaf(node)->entries();
+            for (int i = 0; i < node->count; i++) {
+                if (entries[i].key != node->keys[i]) {
+                    fail("entry %d sits under key %d", entries[i].key,
+                         node->keys[i]);
+                }
+            }
+            return 0;
+        }
+        auto* inner = Tree::asInner(node);
+        int depth = -1;
+        for (int i = 0; i <= node->count; i++) {
+            const int childDepth = verify<Tree>(
+                inner->children[i], i == 0 ? low : &node->keys[i - 1],
+                i == node->count ? high : &node->keys[i], false);
+            if (depth >= 0 && childDepth != depth) {
+                fail("leaves under key %d at depths %d and %d", node->keys[0],
+                     depth, childDepth);
+            }
+            depth = childDepth;
+        }
+        return depth + 1;
+    }
+
+    // returns the depth of the tree, -1 if empty
+    template <typename Tree>
+    static int checkTree(const Tree& tree) {
+        return tree.root == nullptr
+                   ? -1 : verify<Tree>(tree.root, nullptr, nullptr, true);
+    }
+
+    template <typename Tree>
+    static std::vector<std::pair<int, int>> contents(const Tree& tree) {
+        std::vector<std::pair<int, int>> out;
+        collect<Tree>(tree.root, out);
+        return out;
+    }
+
+    template <typename Tree>
+    static void collect(typename Tree::Node* node,
+                        std::vector<std::pair<int, int>>& out) {
+        if (node == nullptr) {
+            return;
+        }
+        if (node->isLeaf) {
+            auto* entries = Tree::asLeaf(node)->entries();
+            for (int i = 0; i < node->count; i++) {
+                out.emplace_back(entries[i].key, entries[i].value);
+            }
+            return;
+        }
+        for (int i = 0; i <= node->count; i++) {
+            collect<Tree>(Tree::asInner(node)->children[i], out);
+        }
+    }
+};
+
+namespace {
+
+using Tree = AvlTree<int, int, AvlTreeAudit>;
+using Model = std::map<int, int>;
+using BPlusTree = BTree<int, int>;
+
+enum Operation {
+    INSERT,
+    ERASE_KEY,
+    ERASE_NODE,
+    FIND,
+    OPERATION_COUNT,
+};
+
+const char* const OPERATION_NAMES[OPERATION_COUNT] = {
+    "insert", "erase(key)", "erase(node)", "find",
+};
+
+// the AVL bound on levels for n nodes, 1.4405 log2(n + 2) - 0.3277
+double heightBound(const std::size_t n)
+{
+    return 1.4405 * std::log2(static_cast<double>(n) + 2) - 0.3277;
+}
+
+bool sameContents(const std::vector<std::pair<int, int>>& contents,
+                  const Model& model)
+{
+    return contents.size() == model.size() &&
+           std::equal(contents.begin(), contents.end(), model.begin(),
+                      [](const std::pair<int, int>& element,
+                         const Model::value_type& expected) {
+                          return element.first == expected.first &&
+                                 element.second == expected.second;
+                      });
+}
+
+bool sameContents(const Tree& tree, const Model& model)
+{
+    return static_cast<std::size_t>(tree.size()) == model.size() &&
+           sameContents(AvlTreeAudit::contents(tree), model);
+}
+
+bool sameContents(const BPlusTree& tree, const Model& model)
+{
+    return sameContents(BTreeAudit::contents(tree), model);
+}
+
+// picks the operation for a roll in [0, 100)
+Operation pickOperation(const unsigned roll)
+{
+    return roll < 40 ? INSERT
+         : roll < 65 ? ERASE_KEY
+         : roll < 75 ? ERASE_NODE
+         : FIND;
+}
+
+// applies operation to tree and model, timing the tree's part. returns
+// whether both agreed
+template <typename TreeType>
+bool apply(const Operation operation, const int key, const int value,
+           TreeType& tree, Model& model, LatencyHistogram* latencies)
+{
+    const uint64_t start = nowNanoseconds();
+    switch (operation) {
+        case INSERT: {
+            const bool inserted = tree.insert(key, value);
+            latencies[operation].record(nowNanoseconds() - start);
+            return inserted == model.emplace(key, value).second;
+        }
+        case ERASE_KEY: {
+            const bool erased = tree.erase(key);
+            latencies[operation].record(nowNanoseconds() - start);
+            return erased == (model.erase(key) == 1);
+        }
+        case ERASE_NODE: {
+            const bool erased = tree.erase(tree.find(key));
+            latencies[operation].record(nowNanoseconds() - start);
+            return erased == (model.erase(key) == 1);
+        }
+        case FIND: {
+            auto* node = tree.find(key);
+            latencies[operation].record(nowNanoseconds() - start);
+            const auto expected = model.find(key);
+            return expected == model.end()
+                       ? node == nullptr
+                       : node != nullptr && node->getValue() == expected->second;
+        }
+        case OPERATION_COUNT:
+            break;
+    }
+    return true;
+}
+
+// the occasional whole-tree operations: deep copy, compact, placement,
+// rebuild
+bool bulkOperation(std::mt19937& random, Tree& tree, const Model& model)
+{
+    switch (random() % 4) {
+        case 0: {
+            const Tree copy(tree);
+            AvlTreeAudit::checkTree(copy);
+            return sameContents(copy, model);
+        }
+        case 1:
+            tree.compact();
+            return true;
+        case 2: {
+            MemoryPlacement placement;
+            placement.placed = random() % 3 != 0;
+            placement.hugePages = random() % 2 == 0;
+            tree.setPlacement(placement);
+            return true;
+        }
+        default: {
+            std::vector<std::pair<int, int>> sorted(model.begin(), model.end());
+            tree.clear();
+            tree.assignSorted(
+                static_cast<int>(sorted.size()),
+                [&sorted](int i) { return sorted[i].first; },
+                [&sorted](int i) { return sorted[i].second; });
+            return true;
+        }
+    }
+}
+
+// one pass over options.operations random operations. audited passes check
+// every rotation and the whole tree after each operation, timed passes only
+// compare results, outside the timed region
+bool run(const StressOptions& options, const bool audited,
+         LatencyHistogram* latencies, int& maxHeight, double& maxRatio)
+{
+    std::mt19937 random(options.seed);
+    Tree tree;
+    Model model;
+    AvlTreeAudit::enabled = audited;
+
+    for (long i = 0; i < options.operations; i++) {
+        const int key = 1 + static_cast<int>(random() % options.keyRange);
+        const int value = static_cast<int>(random());
+        const Operation operation = pickOperation(random() % 100);
+        bool agrees = apply(operation, key, value, tree, model, latencies);
+        if (agrees && random() % 5000 == 0) {
+            agrees = bulkOperation(random, tree, model);
+        }
+
+        if (audited) {
+            AvlTreeAudit::checkTree(tree);
+            agrees = agrees && sameContents(tree, model);
+        }
+        const int height = AvlTreeAudit::height(tree);
+        if (height > maxHeight) {
+            maxHeight = height;
+        }
+        if (!model.empty()) {
+            const double ratio = (height + 1) / heightBound(model.size());
+            if (ratio > maxRatio) {
+                maxRatio = ratio;
+            }
+            if (ratio > 1) {
+                AvlTreeAudit::fail("tree: %zu nodes but %d levels", model.size(),
+                                   height + 1);
+            }
+        }
+        if (AvlTreeAudit::failed || !agrees) {
+            std::printf("AvlTree: operation %ld (%s %d) %s\n", i,
+                        OPERATION_NAMES[operation], key,
+                        AvlTreeAudit::failed ? AvlTreeAudit::failure
+                                             : "disagrees with the model");
+            return false;
+        }
+    }
+
+    AvlTreeAudit::enabled = false;
+    AvlTreeAudit::checkTree(tree);
+    if (AvlTreeAudit::failed || !sameContents(tree, model)) {
+        std::printf("AvlTree: final tree %s\n",
+                    AvlTreeAudit::failed ? AvlTreeAudit::failure
+                                         : "disagrees with the model");
+        return false;
+    }
+    return true;
+}
+
+// the occasional whole-tree operations of a BTree: rebuild, on a few
+// threads, compact
+bool bulkOperation(std::mt19937& random, BPlusTree& tree, const Model& model)
+{
+    if (random() % 2 == 0) {
+        tree.compact();
+        return true;
+    }
+    std::vector<std::pair<int, int>> sorted(model.begin(), model.end());
+    const int threads = 1 + static_cast<int>(random() % 4);
+    tree.clear();
+    tree.assignSorted(
+        static_cast<int>(sorted.size()),
+        [&sorted](int i) { return sorted[i].first; },
+        [&sorted](int i) { return sorted[i].second; }, threads);
+    return true;
+}
+
+// the same passes as run(), for BTree. audited passes check the whole tree
+// after each operation
+bool runBTree(const StressOptions& options, const bool audited,
+              LatencyHistogram* latencies, int& maxDepth)
+{
+    std::mt19937 random(options.seed);
+    BPlusTree tree;
+    Model model;
+
+    for (long i = 0; i < options.operations; i++) {
+        const int key = 1 + static_cast<int>(random() % options.keyRange);
+        const int value = static_cast<int>(random());
+        const Operation operation = pickOperation(random() % 100);
+        bool agrees = apply(operation, key, value, tree, model, latencies);
+        if (agrees && random() % 5000 == 0) {
+            agrees = bulkOperation(random, tree, model);
+        }
+
+        if (audited) {
+            const int depth = BTreeAudit::checkTree(tree);
+            if (depth > maxDepth) {
+                maxDepth = depth;
+            }
+            agrees = agrees && sameContents(tree, model);
+        }
+        if (BTreeAudit::failed || !agrees) {
+            std::printf("BTree: operation %ld (%s %d) %s\n", i,
+                        OPERATION_NAMES[operation], key,
+                        BTreeAudit::failed ? BTreeAudit::failure
+                                           : "disagrees with the model");
+            return false;
+        }
+    }
+
+    BTreeAudit::checkTree(tree);
+    if (BTreeAudit::failed || !sameContents(tree, model)) {
+        std::printf("BTree: final tree %s\n",
+                    BTreeAudit::failed ? BTreeAudit::failure
+                                       : "disagrees with the model");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool stressAvlTree(const StressOptions& options)
+{
+    LatencyHistogram audited[OPERATION_COUNT];
+    LatencyHistogram timed[OPERATION_COUNT];
+    int maxHeight = -1;
+    double maxRatio = 0;
+    if (!run(options, true, audited, maxHeight, maxRatio) ||
+        !run(options, false, timed, maxHeight, maxRatio)) {
+        return false;
+    }
+
+    std::printf("AvlTree: %ld operations, keys in [1, %d], max height %d, "
+                "max levels / AVL bound %.3f\n", options.operations,
+                options.keyRange, maxHeight, maxRatio);
+    for (int operation = 0; operation < OPERATION_COUNT; operation++) {
+        timed[operation].print(OPERATION_NAMES[operation], options.histograms);
+    }
+    return true;
+}
+
+bool stressBTree(const StressOptions& options)
+{
+    LatencyHistogram audited[OPERATION_COUNT];
+    LatencyHistogram timed[OPERATION_COUNT];
+    int maxDepth = -1;
+    if (!runBTree(options, true, audited, maxDepth) ||
+        !runBTree(options, false, timed, maxDepth)) {
+        return false;
+    }
+
+    std::printf("BTree: %ld operations, keys in [1, %d], max depth %d\n",
+                options.operations, options.keyRange, maxDepth);
+    for (int operation = 0; operation < OPERATION_COUNT; operation++) {
+        timed[operation].print(OPERATION_NAMES[operation], options.histograms);
+    }
+    return true;
+}
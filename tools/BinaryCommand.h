@@ -0,0 +1,82 @@
+#ifndef DS_WET_1_BINARY_COMMAND_H
+#define DS_WET_1_BINARY_COMMAND_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Command.h"
+
+// Binary encoding of the main26a1.cpp command stream. A log starts with
+// the four bytes of LOG_MAGIC, followed by one record per command: the
+// opcode byte and then its operands, each as a zigzag LEB128 varint, so
+// small ids and negative (invalid) ones take a byte or two instead of a
+// whole decimal token.
+
+static const unsigned char LOG_MAGIC[4] = {'T', 'S', 'C', 1};
+
+// opcode byte plus two operands of at most five bytes each
+static const std::size_t MAX_RECORD = 11;
+
+inline unsigned char* encodeVarint(unsigned char* out, const int value)
+{
+    uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^
+                      static_cast<uint32_t>(value >> 31);
+    while (zigzag >= 0x80) {
+        *out++ = static_cast<unsigned char>(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    *out++ = static_cast<unsigned char>(zigzag);
+    return out;
+}
+
+// false if the varint is truncated, longer than five bytes or holds more
+// than 32 bits, which only the low four bits of a fifth byte can add to
+inline bool decodeVarint(const unsigned char*& cursor, const unsigned char* end,
+                         int& value)
+{
+    uint32_t zigzag = 0;
+    for (int shift = 0; shift < 35 && cursor != end; shift += 7) {
+        const unsigned char byte = *cursor++;
+        if (shift == 28 && byte > 0x0f) {
+            return false;
+        }
+        zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            value = static_cast<int>((zigzag >> 1) ^ (0u - (zigzag & 1)));
+            return true;
+        }
+    }
+    return false;
+}
+
+// writes the record of command into out, which must have MAX_RECORD bytes.
+// returns the end of the record
+inline unsigned char* encodeCommand(unsigned char* out, const Command& command)
+{
+    *out++ = static_cast<unsigned char>(command.op);
+    out = encodeVarint(out, command.arg1);
+    if (operandCount(command.op) == 2) {
+        out = encodeVarint(out, command.arg2);
+    }
+    return out;
+}
+
+// reads the record at cursor and advances past it. false on an unknown
+// opcode or a record cut short by end
+inline bool decodeCommand(const unsigned char*& cursor, const unsigned char* end,
+                          Command& command)
+{
+    if (cursor == end || !isValidOpcode(*cursor)) {
+        return false;
+    }
+    command.op = static_cast<Opcode>(*cursor++);
+    command.arg2 = 0;
+    if (!decodeVarint(cursor, end, command.arg1)) {
+        return false;
+    }
+    return operandCount(command.op) == 1 ||
+           decodeVarint(cursor, end, command.arg2);
+}
+
+
+#endif //DS_WET_1_BINARY_COMMAND_H
@@ -0,0 +1,177 @@
+#include "Command.h"
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+
+static const char* const OPCODE_NAMES[OPCODE_COUNT] = {
+    "addStudent",
+    "removeStudent",
+    "addCourse",
+    "removeCourse",
+    "enrollStudent",
+    "completeCourse",
+    "awardAcademicPoints",
+    "getStudentPoints",
+};
+
+static const int OPERAND_COUNTS[OPCODE_COUNT] = {1, 1, 2, 1, 2, 2, 1, 1};
+
+static const char* const STATUS_NAMES[] = {
+    "SUCCESS",
+    "ALLOCATION_ERROR",
+    "INVALID_INPUT",
+    "FAILURE",
+};
+
+const char* opcodeName(const Opcode op)
+{
+    return OPCODE_NAMES[static_cast<int>(op) - 1];
+}
+
+int operandCount(const Opcode op)
+{
+    return OPERAND_COUNTS[static_cast<int>(op) - 1];
+}
+
+bool isValidOpcode(const int op)
+{
+    return op >= 1 && op <= OPCODE_COUNT;
+}
+
+bool isMutation(const Opcode op)
+{
+    return op != Opcode::GET_STUDENT_POINTS;
+}
+
+static bool isSpace(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+           c == '\f';
+}
+
+static const char* skipSpace(const char* cursor, const char* end)
+{
+    while (cursor != end && isSpace(*cursor)) {
+        cursor++;
+    }
+    return cursor;
+}
+
+// reads an optionally signed decimal int at cursor, stopping at the first
+// character that is not a digit
+static ParseResult parseInt(const char*& cursor, const char* end,
+                            const bool last, int& value)
+{
+    const char* digits = cursor;
+    if (digits != end && (*digits == '+' || *digits == '-')) {
+        digits++;
+    }
+    const char* digitsEnd = digits;
+    long long magnitude = 0;
+    while (digitsEnd != end && *digitsEnd >= '0' && *digitsEnd <= '9') {
+        if (magnitude <= static_cast<long long>(INT_MAX) + 1) {
+            magnitude = magnitude * 10 + (*digitsEnd - '0');
+        }
+        digitsEnd++;
+    }
+    if (digitsEnd == end && !last) {
+        return ParseResult::INCOMPLETE;
+    }
+    const long long parsed = *cursor == '-' ? -magnitude : magnitude;
+    if (digitsEnd == digits || parsed < INT_MIN || parsed > INT_MAX) {
+        return ParseResult::INVALID_FORMAT;
+    }
+    value = static_cast<int>(parsed);
+    cursor = digitsEnd;
+    return ParseResult::OK;
+}
+
+ParseResult parseCommand(const char*& cursor, const char* const end,
+                         const bool last, Command& command, char* unknownName,
+                         const std::size_t nameSize)
+{
+    cursor = skipSpace(cursor, end);
+    if (cursor == end) {
+        return ParseResult::END;
+    }
+    const char* nameEnd = cursor;
+    while (nameEnd != end && !isSpace(*nameEnd)) {
+        nameEnd++;
+    }
+    if (nameEnd == end && !last) {
+        return ParseResult::INCOMPLETE;
+    }
+    const std::size_t nameLength = nameEnd - cursor;
+
+    int op = 1;
+    while (op <= OPCODE_COUNT &&
+           !(std::strlen(OPCODE_NAMES[op - 1]) == nameLength &&
+             std::strncmp(OPCODE_NAMES[op - 1], cursor, nameLength) == 0)) {
+        op++;
+    }
+    if (op > OPCODE_COUNT) {
+        const std::size_t copied = nameLength < nameSize ? nameLength : nameSize - 1;
+        std::memcpy(unknownName, cursor, copied);
+        unknownName[copied] = '\0';
+        return ParseResult::UNKNOWN_COMMAND;
+    }
+
+    Command parsed{static_cast<Opcode>(op), 0, 0};
+    const char* operand = nameEnd;
+    for (int i = 0; i < operandCount(parsed.op); i++) {
+        operand = skipSpace(operand, end);
+        if (operand == end) {
+            return last ? ParseResult::INVALID_FORMAT : ParseResult::INCOMPLETE;
+        }
+        const ParseResult result = parseInt(operand, end, last,
+                                            i == 0 ? parsed.arg1 : parsed.arg2);
+        if (result != ParseResult::OK) {
+            return result;
+        }
+    }
+    command = parsed;
+    cursor = operand;
+    return ParseResult::OK;
+}
+
+int execute(TechSystem& system, const Command& command, char* reply,
+            const std::size_t replySize)
+{
+    StatusType status = StatusType::SUCCESS;
+    switch (command.op) {
+        case Opcode::ADD_STUDENT:
+            status = system.addStudent(command.arg1);
+            break;
+        case Opcode::REMOVE_STUDENT:
+            status = system.removeStudent(command.arg1);
+            break;
+        case Opcode::ADD_COURSE:
+            status = system.addCourse(command.arg1, command.arg2);
+            break;
+        case Opcode::REMOVE_COURSE:
+            status = system.removeCourse(command.arg1);
+            break;
+        case Opcode::ENROLL_STUDENT:
+            status = system.enrollStudent(command.arg1, command.arg2);
+            break;
+        case Opcode::COMPLETE_COURSE:
+            status = system.completeCourse(command.arg1, command.arg2);
+            break;
+        case Opcode::AWARD_ACADEMIC_POINTS:
+            status = system.awardAcademicPoints(command.arg1);
+            break;
+        case Opcode::GET_STUDENT_POINTS: {
+            output_t<int> result = system.getStudentPoints(command.arg1);
+            if (result.status() == StatusType::SUCCESS) {
+                return std::snprintf(reply, replySize, "%s: %s, %d\n",
+                                     opcodeName(command.op), STATUS_NAMES[0],
+                                     result.ans());
+            }
+            status = result.status();
+            break;
+        }
+    }
+    return std::snprintf(reply, replySize, "%s: %s\n", opcodeName(command.op),
+                         STATUS_NAMES[static_cast<int>(status)]);
+}
@@ -0,0 +1,70 @@
+#ifndef DS_WET_1_COMMAND_H
+#define DS_WET_1_COMMAND_H
+
+#include <cstddef>
+
+#include "TechSystem26a1.h"
+
+// The command stream of main26a1.cpp, for the tools that drive a TechSystem
+// from something other than stdin. Replies are formatted exactly like
+// main26a1.cpp prints them, so they can be diffed against tests/*.out.
+
+enum class Opcode : unsigned char {
+    ADD_STUDENT = 1,
+    REMOVE_STUDENT,
+    ADD_COURSE,
+    REMOVE_COURSE,
+    ENROLL_STUDENT,
+    COMPLETE_COURSE,
+    AWARD_ACADEMIC_POINTS,
+    GET_STUDENT_POINTS,
+};
+
+static const int OPCODE_COUNT = 8;
+
+struct Command {
+    Opcode op;
+    int arg1;
+    int arg2;
+};
+
+enum class ParseResult {
+    OK,
+    UNKNOWN_COMMAND,
+    INVALID_FORMAT,
+    INCOMPLETE, // the text ends inside a command that may go on
+    END,        // nothing but whitespace left
+};
+
+const char* opcodeName(Opcode op);
+
+int operandCount(Opcode op);
+
+bool isValidOpcode(int op);
+
+// everything but getStudentPoints changes the system
+bool isMutation(Opcode op);
+
+// parses the next command of the text [cursor, end) the way main26a1.cpp
+// reads its input: tokens are separated by any whitespace, line breaks
+// included, and whatever follows the operands of a command starts the next
+// one, so "addStudent 5 7" is addStudent 5 followed by the unknown command
+// 7. operands are read like cin >> int reads them, so "5x" is 5 followed by
+// x. unless last is set the text may go on past end, and a command cut off
+// by end is INCOMPLETE instead of malformed. cursor is moved past the
+// command on OK and past the leading whitespace otherwise. the name of an
+// unknown command is copied into unknownName, truncated to fit nameSize
+ParseResult parseCommand(const char*& cursor, const char* end, bool last,
+                         Command& command, char* unknownName,
+                         std::size_t nameSize);
+
+// runs command against system and writes its newline terminated reply into
+// reply. returns the reply length
+int execute(TechSystem& system, const Command& command, char* reply,
+            std::size_t replySize);
+
+// longest reply execute can produce, including the terminating null
+static const std::size_t MAX_REPLY = 64;
+
+
+#endif //DS_WET_1_COMMAND_H
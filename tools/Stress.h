@@ -0,0 +1,92 @@
+#ifndef DS_WET_1_STRESS_H
+#define DS_WET_1_STRESS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+// Shared pieces of the stress harness, tools/stress26a1.cpp.
+
+inline uint64_t nowNanoseconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000u + now.tv_nsec;
+}
+
+// latencies of one operation, in power of two buckets of nanoseconds
+class LatencyHistogram {
+    static const int BUCKETS = 40;
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t samples = 0;
+    uint64_t total = 0;
+    uint64_t maximum = 0;
+
+public:
+
+    void record(const uint64_t nanoseconds) {
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && (uint64_t(1) << (bucket + 1)) <= nanoseconds) {
+            bucket++;
+        }
+        counts[bucket]++;
+        samples++;
+        total += nanoseconds;
+        if (nanoseconds > maximum) {
+            maximum = nanoseconds;
+        }
+    }
+
+    // upper edge of the bucket holding the given fraction of samples
+    uint64_t percentile(const double fraction) const {
+        const uint64_t wanted = static_cast<uint64_t>(fraction * samples);
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < BUCKETS; bucket++) {
+            seen += counts[bucket];
+            if (seen > wanted) {
+                return uint64_t(1) << (bucket + 1);
+            }
+        }
+        return maximum;
+    }
+
+    // one summary line, followed by the non-empty buckets if withBuckets
+    void print(const char* name, const bool withBuckets) const {
+        if (samples == 0) {
+            return;
+        }
+        std::printf("  %-22s %9llu ops  mean %6llu ns  p50 <%6llu  p99 <%7llu"
+                    "  max %8llu\n", name,
+                    static_cast<unsigned long long>(samples),
+                    static_cast<unsigned long long>(total / samples),
+                    static_cast<unsigned long long>(percentile(0.5)),
+                    static_cast<unsigned long long>(percentile(0.99)),
+                    static_cast<unsigned long long>(maximum));
+        for (int bucket = 0; bucket < BUCKETS && withBuckets; bucket++) {
+            if (counts[bucket] > 0) {
+                std::printf("      <%10llu ns  %llu\n",
+                            static_cast<unsigned long long>(uint64_t(1) << (bucket + 1)),
+                            static_cast<unsigned long long>(counts[bucket]));
+            }
+        }
+    }
+};
+
+struct StressOptions {
+    unsigned seed;
+    long operations;
+    int keyRange; // keys are drawn from [1, keyRange]
+    bool histograms; // print the buckets, not just the summary lines
+};
+
+// each returns false after reporting the first mismatch or broken invariant
+
+bool stressAvlTree(const StressOptions& options);
+
+bool stressBTree(const StressOptions& options);
+
+bool stressTechSystem(const StressOptions& options);
+
+
+#endif //DS_WET_1_STRESS_H
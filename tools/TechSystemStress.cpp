@@ -0,0 +1,802 @@
+// Differential stress of TechSystem against a straightforward model built
+// on the standard containers.
+//
+// The system starts out bulk loaded, after a few loads that must be refused,
+// and the model gets the same contents one operation at a time. memoryUsage
+// is checked for consistency along the way.
+// Snapshots are checked against the model when taken, and a few are kept
+// with the contents they should show and checked again after later
+// mutations. Now and then a reader thread walks a snapshot while the
+// writer runs a burst of operations on the system.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "ForkJoin.h"
+#include "Stress.h"
+#include "TechSystem26a1.h"
+
+namespace {
+
+struct ModelStudent {
+    int completionPoints = 0;
+    int joinedAt = 0; // awards given before the student was added
+    int courses = 0;
+    std::vector<std::pair<int, int>> completions; // (time, total points)
+};
+
+struct ModelCourse {
+    int credit = 0;
+    int capacity = 0; // 0 for no limit
+    int completed = 0;
+    std::set<int> enrolled;
+    std::vector<int> waitlist; // in order of arrival
+
+    bool isWaiting(const int studentId) const {
+        return std::find(waitlist.begin(), waitlist.end(), studentId) !=
+               waitlist.end();
+    }
+
+    // seats waitlisted students while there is room
+    int seatWaiting() {
+        int seated = 0;
+        while (!waitlist.empty() &&
+               static_cast<int>(enrolled.size()) < capacity) {
+            enrolled.insert(waitlist.front());
+            waitlist.erase(waitlist.begin());
+            seated++;
+        }
+        return seated;
+    }
+};
+
+// what TechSystem should do, spelled out with no regard for speed
+class Model {
+    std::map<int, ModelStudent> students;
+    std::map<int, ModelCourse> courses;
+    std::vector<int> awardPrefix; // total bonus after each award
+    int totalEnrollments = 0;
+    long long totalCreditsAwarded = 0;
+
+    int bonusAt(const int time) const {
+        return time == 0 ? 0 : awardPrefix[time - 1];
+    }
+
+    int currentTime() const {
+        return static_cast<int>(awardPrefix.size());
+    }
+
+public:
+
+    StatusType addStudent(const int studentId) {
+        if (studentId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        if (students.count(studentId) != 0) {
+            return StatusType::FAILURE;
+        }
+        students[studentId].joinedAt = currentTime();
+        return StatusType::SUCCESS;
+    }
+
+    StatusType removeStudent(const int studentId) {
+        if (studentId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto student = students.find(studentId);
+        if (student == students.end() || student->second.courses > 0) {
+            return StatusType::FAILURE;
+        }
+        students.erase(student);
+        return StatusType::SUCCESS;
+    }
+
+    StatusType addCourse(const int courseId, const int points) {
+        if (courseId <= 0 || points <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        if (courses.count(courseId) != 0) {
+            return StatusType::FAILURE;
+        }
+        courses[courseId].credit = points;
+        return StatusType::SUCCESS;
+    }
+
+    StatusType removeCourse(const int courseId) {
+        if (courseId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto course = courses.find(courseId);
+        if (course == courses.end() || !course->second.enrolled.empty() ||
+            !course->second.waitlist.empty()) {
+            return StatusType::FAILURE;
+        }
+        courses.erase(course);
+        return StatusType::SUCCESS;
+    }
+
+    StatusType enrollStudent(const int studentId, const int courseId) {
+        if (studentId <= 0 || courseId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto student = students.find(studentId);
+        const auto course = courses.find(courseId);
+        if (student == students.end() || course == courses.end() ||
+            course->second.enrolled.count(studentId) != 0 ||
+            course->second.isWaiting(studentId)) {
+            return StatusType::FAILURE;
+        }
+        ModelCourse& target = course->second;
+        if (target.capacity != 0 &&
+            static_cast<int>(target.enrolled.size()) >= target.capacity) {
+            target.waitlist.push_back(studentId);
+        }
+        else {
+            target.enrolled.insert(studentId);
+            totalEnrollments++;
+        }
+        student->second.courses++;
+        return StatusType::SUCCESS;
+    }
+
+    StatusType completeCourse(const int studentId, const int courseId) {
+        if (studentId <= 0 || courseId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto course = courses.find(courseId);
+        if (course == courses.end() || course->second.enrolled.erase(studentId) == 0) {
+            return StatusType::FAILURE;
+        }
+        ModelStudent& student = students[studentId];
+        student.courses--;
+        student.completionPoints += course->second.credit;
+        student.completions.emplace_back(currentTime(), student.completionPoints);
+        course->second.completed++;
+        totalEnrollments--;
+        totalEnrollments += course->second.seatWaiting();
+        totalCreditsAwarded += course->second.credit;
+        return StatusType::SUCCESS;
+    }
+
+    StatusType setCourseCapacity(const int courseId, const int capacity) {
+        if (courseId <= 0 || capacity <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto course = courses.find(courseId);
+        if (course == courses.end()) {
+            return StatusType::FAILURE;
+        }
+        course->second.capacity = capacity;
+        totalEnrollments += course->second.seatWaiting();
+        return StatusType::SUCCESS;
+    }
+
+    StatusType withdrawStudent(const int studentId, const int courseId) {
+        if (studentId <= 0 || courseId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto course = courses.find(courseId);
+        if (course == courses.end()) {
+            return StatusType::FAILURE;
+        }
+        ModelCourse& target = course->second;
+        const auto waiting =
+            std::find(target.waitlist.begin(), target.waitlist.end(), studentId);
+        if (waiting != target.waitlist.end()) {
+            target.waitlist.erase(waiting);
+        }
+        else if (target.enrolled.erase(studentId) == 1) {
+            totalEnrollments--;
+            totalEnrollments += target.seatWaiting();
+        }
+        else {
+            return StatusType::FAILURE;
+        }
+        students[studentId].courses--;
+        return StatusType::SUCCESS;
+    }
+
+    StatusType getWaitlistPosition(const int studentId, const int courseId,
+                                   int& position) const {
+        if (studentId <= 0 || courseId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto course = courses.find(courseId);
+        if (course == courses.end()) {
+            return StatusType::FAILURE;
+        }
+        const std::vector<int>& waitlist = course->second.waitlist;
+        const auto waiting = std::find(waitlist.begin(), waitlist.end(), studentId);
+        if (waiting == waitlist.end()) {
+            return StatusType::FAILURE;
+        }
+        position = static_cast<int>(waiting - waitlist.begin()) + 1;
+        return StatusType::SUCCESS;
+    }
+
+    StatusType awardAcademicPoints(const int points) {
+        if (points <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        awardPrefix.push_back(bonusAt(currentTime()) + points);
+        return StatusType::SUCCESS;
+    }
+
+    StatusType getStudentPoints(const int studentId, int& points) const {
+        if (studentId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto student = students.find(studentId);
+        if (student == students.end()) {
+            return StatusType::FAILURE;
+        }
+        points = student->second.completionPoints +
+                 (bonusAt(currentTime()) - bonusAt(student->second.joinedAt));
+        return StatusType::SUCCESS;
+    }
+
+    StatusType getStudentPointsAsOf(const int studentId, const int time,
+                                    int& points) const {
+        if (studentId <= 0 || time < 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto student = students.find(studentId);
+        if (student == students.end() || time > currentTime() ||
+            time < student->second.joinedAt) {
+            return StatusType::FAILURE;
+        }
+        int completed = 0;
+        for (const auto& completion : student->second.completions) {
+            if (completion.first <= time) {
+                completed = completion.second;
+            }
+        }
+        points = completed + (bonusAt(time) - bonusAt(student->second.joinedAt));
+        return StatusType::SUCCESS;
+    }
+
+    StatusType getCourseStats(const int courseId, CourseStats& stats) const {
+        if (courseId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        const auto course = courses.find(courseId);
+        if (course == courses.end()) {
+            return StatusType::FAILURE;
+        }
+        stats.enrolled = static_cast<int>(course->second.enrolled.size());
+        stats.completed = course->second.completed;
+        stats.pendingCredits =
+            static_cast<long long>(stats.enrolled) * course->second.credit;
+        stats.waitlisted = static_cast<int>(course->second.waitlist.size());
+        return StatusType::SUCCESS;
+    }
+
+    int getTotalEnrollments() const {
+        return totalEnrollments;
+    }
+
+    long long getTotalCreditsAwarded() const {
+        return totalCreditsAwarded;
+    }
+
+    int getCurrentTime() const {
+        return currentTime();
+    }
+
+    int studentCount() const {
+        return static_cast<int>(students.size());
+    }
+
+    int courseCount() const {
+        return static_cast<int>(courses.size());
+    }
+
+    // every (studentId, points) and (courseId, studentId) pair in id order
+    void contents(std::vector<std::pair<int, int>>& points,
+                  std::vector<std::pair<int, int>>& enrollments) const {
+        for (const auto& student : students) {
+            int studentPoints = 0;
+            getStudentPoints(student.first, studentPoints);
+            points.emplace_back(student.first, studentPoints);
+        }
+        for (const auto& course : courses) {
+            for (const int studentId : course.second.enrolled) {
+                enrollments.emplace_back(course.first, studentId);
+            }
+        }
+    }
+};
+
+enum Operation {
+    ADD_STUDENT,
+    REMOVE_STUDENT,
+    ADD_COURSE,
+    REMOVE_COURSE,
+    ENROLL_STUDENT,
+    COMPLETE_COURSE,
+    AWARD_ACADEMIC_POINTS,
+    GET_STUDENT_POINTS,
+    GET_STUDENT_POINTS_AS_OF,
+    GET_COURSE_STATS,
+    SET_COURSE_CAPACITY,
+    WITHDRAW_STUDENT,
+    GET_WAITLIST_POSITION,
+    GET_TOTALS,
+    MEMORY_USAGE,
+    SNAPSHOT,
+    SNAPSHOT_READER,
+    COMPACT,
+    SET_MEMORY_PLACEMENT,
+    OPERATION_COUNT,
+};
+
+const char* const OPERATION_NAMES[OPERATION_COUNT] = {
+    "addStudent", "removeStudent", "addCourse", "removeCourse",
+    "enrollStudent", "completeCourse", "awardAcademicPoints",
+    "getStudentPoints", "getStudentPointsAsOf", "getCourseStats",
+    "setCourseCapacity", "withdrawStudent", "getWaitlistPosition",
+    "getTotals", "memoryUsage", "snapshot", "snapshotReader", "compact",
+    "setMemoryPlacement",
+};
+
+// cumulative weights out of 1000
+const int OPERATION_WEIGHTS[OPERATION_COUNT] = {
+    140, 210, 270, 310, 510, 630, 670, 800, 840, 870, 885, 935, 980, 988,
+    993, 997, 998, 999, 1000,
+};
+
+// snapshots kept for checking again later
+const std::size_t KEPT_SNAPSHOTS = 4;
+
+// operations the writer runs while a reader walks a snapshot
+const int READER_BURST = 200;
+
+// the (studentId, points) and (courseId, studentId) pairs a snapshot shows
+struct SnapshotContents {
+    std::vector<std::pair<int, int>> points;
+    std::vector<std::pair<int, int>> enrollments;
+
+    bool operator==(const SnapshotContents& other) const {
+        return points == other.points && enrollments == other.enrollments;
+    }
+};
+
+SnapshotContents contentsOf(const TechSnapshot& snapshot)
+{
+    SnapshotContents contents;
+    snapshot.forEachStudent([&contents](int studentId, int studentPoints) {
+        contents.points.emplace_back(studentId, studentPoints);
+    });
+    snapshot.forEachEnrollment([&contents](int courseId, int studentId) {
+        contents.enrollments.emplace_back(courseId, studentId);
+    });
+    return contents;
+}
+
+SnapshotContents contentsOf(const Model& model)
+{
+    SnapshotContents contents;
+    model.contents(contents.points, contents.enrollments);
+    return contents;
+}
+
+struct KeptSnapshot {
+    TechSnapshot snapshot;
+    SnapshotContents expected;
+};
+
+// one run of random operations against a system and its model
+class Run {
+    const StressOptions& options;
+    const int courseRange;
+    std::mt19937 random;
+    TechSystem system;
+    Model model;
+    std::vector<KeptSnapshot> kept;
+    std::size_t nextKept = 0;
+    bool viewsBuilt = false; // by a snapshot since the last compact
+
+public:
+    LatencyHistogram latencies[OPERATION_COUNT];
+
+    explicit Run(const StressOptions& options)
+        : options(options), courseRange(options.keyRange / 16 + 1),
+          random(options.seed) {}
+
+    int getCourseRange() const {
+        return courseRange;
+    }
+
+    int pickOperation() {
+        const int roll = static_cast<int>(random() % 1000);
+        int operation = 0;
+        while (roll >= OPERATION_WEIGHTS[operation]) {
+            operation++;
+        }
+        return operation;
+    }
+
+    // fills the empty system through bulkLoad, adding the same students,
+    // courses and enrollments to the model one at a time. loads that must
+    // be refused go first, and must leave the system empty for the real one
+    bool load() {
+        std::vector<int> studentIds;
+        for (int id = 1; id <= options.keyRange; id++) {
+            if (random() % 2 == 0) {
+                studentIds.push_back(id);
+            }
+        }
+        std::vector<int> courseIds;
+        std::vector<int> coursePoints;
+        for (int id = 1; id <= courseRange; id++) {
+            if (random() % 2 == 0) {
+                courseIds.push_back(id);
+                coursePoints.push_back(1 + static_cast<int>(random() % 20));
+            }
+        }
+        std::vector<std::pair<int, int>> enrollments; // (courseId, studentId)
+        for (const int studentId : studentIds) {
+            for (int n = random() % 3; n > 0 && !courseIds.empty(); n--) {
+                enrollments.emplace_back(courseIds[random() % courseIds.size()],
+                                         studentId);
+            }
+        }
+        std::sort(enrollments.begin(), enrollments.end());
+        enrollments.erase(std::unique(enrollments.begin(), enrollments.end()),
+                          enrollments.end());
+        std::vector<int> enrollCourseIds;
+        std::vector<int> enrollStudentIds;
+        for (const auto& enrollment : enrollments) {
+            enrollCourseIds.push_back(enrollment.first);
+            enrollStudentIds.push_back(enrollment.second);
+        }
+
+        const int threads = 1 + static_cast<int>(random() % 4);
+        auto bulkLoad = [&](const std::vector<int>& students,
+                            const std::vector<int>& enrolledStudents) {
+            return system.bulkLoad(
+                students.data(), static_cast<int>(students.size()),
+                courseIds.data(), coursePoints.data(),
+                static_cast<int>(courseIds.size()), enrollCourseIds.data(),
+                enrolledStudents.data(),
+                static_cast<int>(enrolledStudents.size()), threads);
+        };
+        const char* failure = nullptr;
+        if (studentIds.size() > 1) {
+            std::vector<int> unsorted(studentIds);
+            std::swap(unsorted[0], unsorted[1]);
+            if (bulkLoad(unsorted, enrollStudentIds) != StatusType::INVALID_INPUT) {
+                failure = "accepted unsorted students";
+            }
+        }
+        if (failure == nullptr && !enrollStudentIds.empty()) {
+            // still sorted, the last enrollment has the largest student id
+            std::vector<int> unknown(enrollStudentIds);
+            unknown.back() = options.keyRange + 1;
+            if (bulkLoad(studentIds, unknown) != StatusType::FAILURE) {
+                failure = "accepted an enrollment of an unknown student";
+            }
+        }
+        if (failure == nullptr &&
+            bulkLoad(studentIds, enrollStudentIds) != StatusType::SUCCESS) {
+            failure = "failed on valid input";
+        }
+        if (failure == nullptr &&
+            bulkLoad(studentIds, enrollStudentIds) != StatusType::FAILURE) {
+            failure = "loaded a system that was not empty";
+        }
+        if (failure != nullptr) {
+            std::printf("TechSystem: bulkLoad %s\n", failure);
+            return false;
+        }
+
+        for (const int studentId : studentIds) {
+            model.addStudent(studentId);
+        }
+        for (std::size_t i = 0; i < courseIds.size(); i++) {
+            model.addCourse(courseIds[i], coursePoints[i]);
+        }
+        for (const auto& enrollment : enrollments) {
+            model.enrollStudent(enrollment.second, enrollment.first);
+        }
+        output_t<TechSnapshot> snapshot = system.snapshot();
+        viewsBuilt = true;
+        if (snapshot.status() != StatusType::SUCCESS ||
+            !(contentsOf(snapshot.ans()) == contentsOf(model)) ||
+            system.getTotalEnrollments().ans() != model.getTotalEnrollments()) {
+            std::printf("TechSystem: bulkLoad disagrees with the model\n");
+            return false;
+        }
+        std::printf("TechSystem: bulk loaded %zu students, %zu courses, "
+                    "%zu enrollments on %d thread%s\n", studentIds.size(),
+                    courseIds.size(), enrollments.size(), threads,
+                    threads == 1 ? "" : "s");
+        return true;
+    }
+
+    // runs one operation on both and reports the first disagreement.
+    // a few ids are out of range, so invalid input gets exercised too
+    bool step(const long i, const int operation) {
+        const int student =
+            static_cast<int>(random() % (options.keyRange + 2)) - 1;
+        const int course = static_cast<int>(random() % (courseRange + 2)) - 1;
+        const int points = static_cast<int>(random() % 100) - 5;
+        if (apply(operation, student, course, points)) {
+            return true;
+        }
+        std::printf("TechSystem: operation %ld (%s student %d course %d "
+                    "points %d) disagrees with the model\n", i,
+                    OPERATION_NAMES[operation], student, course, points);
+        return false;
+    }
+
+    // every kept snapshot still shows what it showed when taken
+    bool keptSnapshotsHold() const {
+        for (const KeptSnapshot& snapshot : kept) {
+            if (!(contentsOf(snapshot.snapshot) == snapshot.expected)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool finalContentsAgree() {
+        output_t<TechSnapshot> snapshot = system.snapshot();
+        return snapshot.status() == StatusType::SUCCESS &&
+               contentsOf(snapshot.ans()) == contentsOf(model) &&
+               keptSnapshotsHold();
+    }
+
+private:
+
+    bool apply(const int operation, const int student, const int course,
+               const int points) {
+        uint64_t start = nowNanoseconds();
+        switch (operation) {
+            case ADD_STUDENT: {
+                const StatusType status = system.addStudent(student);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.addStudent(student);
+            }
+            case REMOVE_STUDENT: {
+                const StatusType status = system.removeStudent(student);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.removeStudent(student);
+            }
+            case ADD_COURSE: {
+                const StatusType status = system.addCourse(course, points);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.addCourse(course, points);
+            }
+            case REMOVE_COURSE: {
+                const StatusType status = system.removeCourse(course);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.removeCourse(course);
+            }
+            case ENROLL_STUDENT: {
+                const StatusType status = system.enrollStudent(student, course);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.enrollStudent(student, course);
+            }
+            case COMPLETE_COURSE: {
+                const StatusType status = system.completeCourse(student, course);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.completeCourse(student, course);
+            }
+            case AWARD_ACADEMIC_POINTS: {
+                const StatusType status = system.awardAcademicPoints(points);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.awardAcademicPoints(points);
+            }
+            case GET_STUDENT_POINTS: {
+                output_t<int> result = system.getStudentPoints(student);
+                latencies[operation].record(nowNanoseconds() - start);
+                int expected = 0;
+                const StatusType status = model.getStudentPoints(student, expected);
+                return result.status() == status &&
+                       (status != StatusType::SUCCESS || result.ans() == expected);
+            }
+            case GET_STUDENT_POINTS_AS_OF: {
+                const int time =
+                    static_cast<int>(random() % (model.getCurrentTime() + 3)) - 1;
+                start = nowNanoseconds();
+                output_t<int> result = system.getStudentPointsAsOf(student, time);
+                latencies[operation].record(nowNanoseconds() - start);
+                int expected = 0;
+                const StatusType status =
+                    model.getStudentPointsAsOf(student, time, expected);
+                return result.status() == status &&
+                       (status != StatusType::SUCCESS || result.ans() == expected);
+            }
+            case GET_COURSE_STATS: {
+                output_t<CourseStats> result = system.getCourseStats(course);
+                latencies[operation].record(nowNanoseconds() - start);
+                CourseStats expected;
+                const StatusType status = model.getCourseStats(course, expected);
+                const CourseStats stats = result.ans();
+                return result.status() == status &&
+                       (status != StatusType::SUCCESS ||
+                        (stats.enrolled == expected.enrolled &&
+                         stats.completed == expected.completed &&
+                         stats.pendingCredits == expected.pendingCredits &&
+                         stats.waitlisted == expected.waitlisted));
+            }
+            case SET_COURSE_CAPACITY: {
+                // small limits, so courses fill up and waitlists form
+                const int capacity = points / 8;
+                start = nowNanoseconds();
+                const StatusType status = system.setCourseCapacity(course, capacity);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.setCourseCapacity(course, capacity);
+            }
+            case WITHDRAW_STUDENT: {
+                const StatusType status = system.withdrawStudent(student, course);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == model.withdrawStudent(student, course);
+            }
+            case GET_WAITLIST_POSITION: {
+                output_t<int> result = system.getWaitlistPosition(student, course);
+                latencies[operation].record(nowNanoseconds() - start);
+                int expected = 0;
+                const StatusType status =
+                    model.getWaitlistPosition(student, course, expected);
+                return result.status() == status &&
+                       (status != StatusType::SUCCESS || result.ans() == expected);
+            }
+            case GET_TOTALS: {
+                output_t<int> enrollments = system.getTotalEnrollments();
+                output_t<long long> credits = system.getTotalCreditsAwarded();
+                output_t<int> time = system.getCurrentTime();
+                latencies[operation].record(nowNanoseconds() - start);
+                return enrollments.ans() == model.getTotalEnrollments() &&
+                       credits.ans() == model.getTotalCreditsAwarded() &&
+                       time.ans() == model.getCurrentTime();
+            }
+            case MEMORY_USAGE: {
+                const MemoryUsage usage = system.memoryUsage();
+                latencies[operation].record(nowNanoseconds() - start);
+                return usageHolds(usage);
+            }
+            case SNAPSHOT: {
+                output_t<TechSnapshot> snapshot = system.snapshot();
+                latencies[operation].record(nowNanoseconds() - start);
+                viewsBuilt = true;
+                return snapshot.status() == StatusType::SUCCESS &&
+                       keep(snapshot.ans()) && keptSnapshotsHold();
+            }
+            case SNAPSHOT_READER: {
+                output_t<TechSnapshot> snapshot = system.snapshot();
+                latencies[operation].record(nowNanoseconds() - start);
+                viewsBuilt = true;
+                return snapshot.status() == StatusType::SUCCESS &&
+                       readWhileWriting(snapshot.ans());
+            }
+            case COMPACT: {
+                const StatusType status = system.compact();
+                latencies[operation].record(nowNanoseconds() - start);
+                viewsBuilt = false;
+                return status == StatusType::SUCCESS;
+            }
+            case SET_MEMORY_PLACEMENT: {
+                MemoryPlacement placement;
+                placement.placed = points % 3 != 0;
+                placement.hugePages = points % 2 == 0;
+                start = nowNanoseconds();
+                const StatusType status = system.setMemoryPlacement(placement);
+                latencies[operation].record(nowNanoseconds() - start);
+                return status == StatusType::SUCCESS;
+            }
+        }
+        return true;
+    }
+
+    // no part reports more live bytes than it reserves, the maps and the
+    // store hold something while there are students and courses, and the
+    // views take nothing until a snapshot builds them
+    bool usageHolds(const MemoryUsage& usage) const {
+        const TreeMemory parts[] = {usage.studentMap, usage.courseMap,
+                                    usage.enrollmentTrees, usage.studentStore,
+                                    usage.snapshotViews};
+        for (const TreeMemory& part : parts) {
+            if (part.liveBytes > part.reservedBytes) {
+                return false;
+            }
+        }
+        if (model.studentCount() > 0 && (usage.studentMap.liveBytes == 0 ||
+                                         usage.studentStore.liveBytes == 0)) {
+            return false;
+        }
+        if (model.courseCount() > 0 && usage.courseMap.liveBytes == 0) {
+            return false;
+        }
+        if (model.getTotalEnrollments() > 0 &&
+            usage.enrollmentTrees.liveBytes == 0) {
+            return false;
+        }
+        return viewsBuilt || usage.snapshotViews.liveBytes == 0;
+    }
+
+    // checks a fresh snapshot against the model and keeps it in place of
+    // the oldest kept one
+    bool keep(const TechSnapshot& snapshot) {
+        KeptSnapshot fresh{snapshot, contentsOf(model)};
+        if (!(contentsOf(snapshot) == fresh.expected)) {
+            return false;
+        }
+        if (kept.size() < KEPT_SNAPSHOTS) {
+            kept.push_back(fresh);
+        }
+        else {
+            kept[nextKept] = fresh;
+            nextKept = (nextKept + 1) % KEPT_SNAPSHOTS;
+        }
+        return true;
+    }
+
+    // walks the snapshot on another thread, over and over, while this one
+    // runs a burst of operations on the system
+    bool readWhileWriting(const TechSnapshot& snapshot) {
+        const SnapshotContents expected = contentsOf(model);
+        std::atomic<bool> writing(true);
+        std::atomic<bool> readsHeld(true);
+        auto reader = [&]() {
+            // passes are capped in case both sides end up on this thread
+            for (int pass = 0; pass == 0 || (writing.load() && pass < 64);
+                 pass++) {
+                if (!(contentsOf(snapshot) == expected)) {
+                    readsHeld.store(false);
+                }
+            }
+        };
+        bool writesAgree = true;
+        auto writer = [&]() {
+            for (int i = 0; i < READER_BURST && writesAgree; i++) {
+                int operation = pickOperation();
+                while (operation == SNAPSHOT || operation == SNAPSHOT_READER) {
+                    operation = pickOperation();
+                }
+                writesAgree = step(i, operation);
+            }
+            writing.store(false);
+        };
+        forkJoin(reader, writer);
+        if (!readsHeld.load()) {
+            std::printf("TechSystem: a snapshot changed under its reader\n");
+        }
+        return writesAgree && readsHeld.load() && contentsOf(snapshot) == expected;
+    }
+};
+
+} // namespace
+
+bool stressTechSystem(const StressOptions& options)
+{
+    Run run(options);
+    if (!run.load()) {
+        return false;
+    }
+    for (long i = 0; i < options.operations; i++) {
+        if (!run.step(i, run.pickOperation())) {
+            return false;
+        }
+    }
+
+    if (!run.finalContentsAgree()) {
+        std::printf("TechSystem: final contents disagree with the model\n");
+        return false;
+    }
+    std::printf("TechSystem: %ld operations, student ids in [1, %d], "
+                "course ids in [1, %d]\n", options.operations, options.keyRange,
+                run.getCourseRange());
+    for (int operation = 0; operation < OPERATION_COUNT; operation++) {
+        run.latencies[operation].print(OPERATION_NAMES[operation],
+                                       options.histograms);
+    }
+    return true;
+}
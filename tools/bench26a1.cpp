@@ -0,0 +1,229 @@
+// Measures getStudentPoints on a large system with its maps and student
+// store on the heap and in placed memory, with and without transparent
+// huge pages, to show how much of a lookup goes to TLB misses.
+//
+//     bench26a1 [-v] [-n students] [-q queries] [-numa node]
+//
+// Every mode loads the same students with bulkLoad, moves the maps with
+// setMemoryPlacement and then looks up the same uniformly random ids, once
+// untimed per call for the mean and once timed per call for the latency
+// percentiles. Where the kernel allows it, dTLB load misses per lookup are
+// counted too. -numa binds the placed modes to the given node, and -v
+// prints the full latency histograms. bench26a1 measures the AvlTree id
+// maps and bench26a1_btree, built with TECH_SYSTEM_BTREE, the BTree ones.
+// The placed modes move the student store's field arrays in both, and the
+// map nodes only with AvlTree: BTree ignores placement, so its nodes stay
+// on the heap, as the output says. The huge page figure after each mode is
+// process wide: all anonymous memory of the bench that huge pages back,
+// placed or not, including the query and id vectors.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <random>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Stress.h"
+#include "TechSystem26a1.h"
+
+namespace {
+
+// keeps the lookups from being optimized away
+volatile long long checksumSink;
+
+struct Mode {
+    const char* name;
+    MemoryPlacement placement;
+};
+
+// counts dTLB load misses of this thread, if perf events are available
+class TlbMissCounter {
+    int descriptor = -1;
+
+public:
+
+    TlbMissCounter() {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_DTLB |
+                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        descriptor = static_cast<int>(
+            syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+
+    TlbMissCounter(const TlbMissCounter&) = delete;
+
+    TlbMissCounter& operator=(const TlbMissCounter&) = delete;
+
+    ~TlbMissCounter() {
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+    }
+
+    bool isAvailable() const {
+        return descriptor >= 0;
+    }
+
+    void start() {
+        if (descriptor >= 0) {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    long long stop() {
+        long long misses = 0;
+        if (descriptor >= 0) {
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(descriptor, &misses, sizeof(misses)) != sizeof(misses)) {
+                misses = 0;
+            }
+        }
+        return misses;
+    }
+};
+
+// all anonymous memory of this process backed by huge pages, not just the
+// placed regions, -1 if unknown
+long hugePageKilobytes()
+{
+    FILE* file = std::fopen("/proc/self/smaps_rollup", "r");
+    if (file == nullptr) {
+        return -1;
+    }
+    long kilobytes = -1;
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        if (std::sscanf(line, "AnonHugePages: %ld kB", &kilobytes) == 1) {
+            break;
+        }
+    }
+    std::fclose(file);
+    return kilobytes;
+}
+
+bool runMode(const Mode& mode, const int students,
+             const std::vector<int>& queries, const bool histograms)
+{
+    std::vector<int> ids(students);
+    for (int i = 0; i < students; i++) {
+        ids[i] = i + 1;
+    }
+    TechSystem* system = new TechSystem();
+    if (system->bulkLoad(ids.data(), students, nullptr, nullptr, 0, nullptr,
+                         nullptr, 0, 1) != StatusType::SUCCESS ||
+        system->setMemoryPlacement(mode.placement) != StatusType::SUCCESS) {
+        std::printf("%-26s could not be set up\n", mode.name);
+        delete system;
+        return false;
+    }
+    const long hugeKilobytes = hugePageKilobytes();
+
+    // untimed per call, so the mean is free of clock overhead
+    TlbMissCounter tlbMisses;
+    long long checksum = 0;
+    tlbMisses.start();
+    const uint64_t start = nowNanoseconds();
+    for (const int id : queries) {
+        checksum += system->getStudentPoints(id).ans();
+    }
+    const uint64_t elapsed = nowNanoseconds() - start;
+    const long long misses = tlbMisses.stop();
+
+    LatencyHistogram latencies;
+    for (const int id : queries) {
+        const uint64_t before = nowNanoseconds();
+        checksum += system->getStudentPoints(id).ans();
+        latencies.record(nowNanoseconds() - before);
+    }
+
+    std::printf("%-26s mean %7.1f ns", mode.name,
+                static_cast<double>(elapsed) / queries.size());
+    if (tlbMisses.isAvailable()) {
+        std::printf("  dTLB misses/lookup %6.2f",
+                    static_cast<double>(misses) / queries.size());
+    }
+    if (hugeKilobytes >= 0) {
+        std::printf("  process huge pages %6ld MB", hugeKilobytes / 1024);
+    }
+    std::printf("\n");
+    checksumSink = checksum;
+    latencies.print("per call", histograms);
+    delete system;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int students = 1 << 21;
+    long queryCount = 1 << 21;
+    int numaNode = -1;
+    bool histograms = false;
+    for (int arg = 1; arg < argc; arg++) {
+        if (std::strcmp(argv[arg], "-v") == 0) {
+            histograms = true;
+        }
+        else if (arg + 1 < argc && std::strcmp(argv[arg], "-n") == 0) {
+            students = std::atoi(argv[++arg]);
+        }
+        else if (arg + 1 < argc && std::strcmp(argv[arg], "-q") == 0) {
+            queryCount = std::atol(argv[++arg]);
+        }
+        else if (arg + 1 < argc && std::strcmp(argv[arg], "-numa") == 0) {
+            numaNode = std::atoi(argv[++arg]);
+        }
+        else {
+            std::fprintf(stderr, "usage: %s [-v] [-n students] [-q queries] "
+                                 "[-numa node]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (students <= 0 || queryCount <= 0) {
+        std::fprintf(stderr, "%s: counts must be positive\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    std::vector<int> queries(queryCount);
+    for (int& id : queries) {
+        id = 1 + static_cast<int>(random() % students);
+    }
+
+    const Mode modes[] = {
+        {"heap", MemoryPlacement{}},
+        {"placed, huge pages off", MemoryPlacement{true, false, numaNode}},
+        {"placed, huge pages on", MemoryPlacement{true, true, numaNode}},
+    };
+#ifdef TECH_SYSTEM_BTREE
+    const char* const backend = "BTree";
+    const char* const placed =
+        "student store arrays (BTree nodes stay on the heap)";
+#else
+    const char* const backend = "AvlTree";
+    const char* const placed = "id map nodes and student store arrays";
+#endif
+    std::printf("%s id maps, %d students, %ld lookups", backend, students,
+                queryCount);
+    if (numaNode >= 0) {
+        std::printf(", placed modes bound to NUMA node %d", numaNode);
+    }
+    std::printf("\nplaced modes place the %s\n", placed);
+    bool allRan = true;
+    for (const Mode& mode : modes) {
+        allRan = runMode(mode, students, queries, histograms) && allRan;
+    }
+    return allRan ? 0 : 1;
+}
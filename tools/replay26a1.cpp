@@ -0,0 +1,95 @@
+// Runs a binary command log (see BinaryCommand.h) against a fresh
+// TechSystem and prints the replies main26a1.cpp would print for the same
+// commands, so the output can be diffed against tests/*.out.
+//
+//     replay26a1 [-q] <log>
+//
+// The log is mapped rather than read, and replies go out through one large
+// buffer, so a replay is bound by the TechSystem calls rather than by I/O.
+// With -q the replies are dropped and the command rate goes to stderr.
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BinaryCommand.h"
+
+static const std::size_t OUTPUT_BUFFER = 1 << 20;
+
+int main(int argc, char* argv[])
+{
+    const bool quiet = argc == 3 && std::strcmp(argv[1], "-q") == 0;
+    if (argc != 2 && !quiet) {
+        std::fprintf(stderr, "usage: %s [-q] <log>\n", argv[0]);
+        return 1;
+    }
+    const char* path = argv[argc - 1];
+
+    const int file = open(path, O_RDONLY);
+    struct stat info;
+    if (file < 0 || fstat(file, &info) < 0) {
+        std::perror(path);
+        return 1;
+    }
+    const std::size_t length = info.st_size;
+    const unsigned char* log = static_cast<const unsigned char*>(
+        length > 0 ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0)
+                   : MAP_FAILED);
+    if (log == MAP_FAILED || length < sizeof(LOG_MAGIC) ||
+        std::memcmp(log, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        std::fprintf(stderr, "%s: not a command log\n", path);
+        return 1;
+    }
+    madvise(const_cast<unsigned char*>(log), length, MADV_SEQUENTIAL);
+
+    char* output = new char[OUTPUT_BUFFER];
+    std::size_t buffered = 0;
+    TechSystem* system = new TechSystem();
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    const unsigned char* cursor = log + sizeof(LOG_MAGIC);
+    const unsigned char* const end = log + length;
+    long commands = 0;
+    bool corrupt = false;
+    Command command;
+    while (cursor != end) {
+        const unsigned char* record = cursor;
+        if (!decodeCommand(cursor, end, command)) {
+            std::fprintf(stderr, "%s: corrupt record at offset %ld\n", path,
+                         static_cast<long>(record - log));
+            corrupt = true;
+            break;
+        }
+        if (buffered + MAX_REPLY > OUTPUT_BUFFER) {
+            if (!quiet) {
+                std::fwrite(output, 1, buffered, stdout);
+            }
+            buffered = 0;
+        }
+        buffered += execute(*system, command, output + buffered, MAX_REPLY);
+        commands++;
+    }
+    if (!quiet) {
+        std::fwrite(output, 1, buffered, stdout);
+    }
+
+    timespec finish;
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    if (quiet && !corrupt) {
+        const double seconds = (finish.tv_sec - start.tv_sec) +
+                               (finish.tv_nsec - start.tv_nsec) * 1e-9;
+        std::fprintf(stderr, "%ld commands in %.3f s (%.0f commands/s)\n",
+                     commands, seconds, seconds > 0 ? commands / seconds : 0.0);
+    }
+
+    delete system;
+    delete[] output;
+    munmap(const_cast<unsigned char*>(log), length);
+    close(file);
+    return std::fflush(stdout) == 0 && !corrupt ? 0 : 1;
+}
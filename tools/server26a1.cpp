@@ -0,0 +1,343 @@
+// Serves the main26a1.cpp command protocol over a Unix domain socket.
+//
+//     server26a1 <socket path>
+//
+// Clients send commands the way main26a1.cpp reads them, whitespace
+// separated tokens with anything left after the operands of one command
+// starting the next, and get one reply line for each, in the order they were
+// sent, so requests can be pipelined. Every connection is read and parsed on
+// its own thread. Commands that change the system go through a queue to a
+// single writer thread, which applies them in batches. getStudentPoints is
+// answered on the connection thread under a shared lock, after that
+// connection's earlier commands have been applied, so reads of different
+// clients run concurrently with each other.
+// An unknown or malformed command gets the same message main26a1.cpp prints
+// and closes its connection. main26a1.cpp also runs a command whose operand
+// does not parse, with whatever the operand was left at, before printing
+// its message; the server does not.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Command.h"
+#include "DynamicArray.h"
+
+namespace {
+
+struct Connection;
+
+enum class JobKind {
+    MUTATION,
+    READ,
+    ERROR, // reply already filled in, connection closes after it
+};
+
+struct Job {
+    JobKind kind;
+    Command command;
+    Connection* connection;
+    Job* next;
+    int replyLength;
+    char reply[MAX_REPLY];
+};
+
+struct Connection {
+    int socket;
+    pthread_mutex_t mutex;
+    pthread_cond_t applied;
+    int pending; // mutations queued but not applied yet
+};
+
+TechSystem* techSystem = nullptr;
+pthread_rwlock_t systemLock = PTHREAD_RWLOCK_INITIALIZER;
+
+pthread_mutex_t queueMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+Job* queueHead = nullptr;
+Job* queueTail = nullptr;
+
+const std::size_t READ_BUFFER = 1 << 16;
+const std::size_t WRITE_BUFFER = 1 << 16;
+
+void enqueue(Job* job)
+{
+    Connection* connection = job->connection;
+    pthread_mutex_lock(&connection->mutex);
+    connection->pending++;
+    pthread_mutex_unlock(&connection->mutex);
+
+    job->next = nullptr;
+    pthread_mutex_lock(&queueMutex);
+    if (queueTail == nullptr) {
+        queueHead = job;
+    }
+    else {
+        queueTail->next = job;
+    }
+    queueTail = job;
+    pthread_cond_signal(&queueReady);
+    pthread_mutex_unlock(&queueMutex);
+}
+
+void waitApplied(Connection* connection)
+{
+    pthread_mutex_lock(&connection->mutex);
+    while (connection->pending > 0) {
+        pthread_cond_wait(&connection->applied, &connection->mutex);
+    }
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+// applies queued mutations, everything queued so far as one batch
+void* writerLoop(void*)
+{
+    while (true) {
+        pthread_mutex_lock(&queueMutex);
+        while (queueHead == nullptr) {
+            pthread_cond_wait(&queueReady, &queueMutex);
+        }
+        Job* batch = queueHead;
+        queueHead = nullptr;
+        queueTail = nullptr;
+        pthread_mutex_unlock(&queueMutex);
+
+        pthread_rwlock_wrlock(&systemLock);
+        for (Job* job = batch; job != nullptr; job = job->next) {
+            job->replyLength = execute(*techSystem, job->command, job->reply,
+                                       MAX_REPLY);
+        }
+        pthread_rwlock_unlock(&systemLock);
+
+        for (Job* job = batch; job != nullptr;) {
+            // the job may be gone as soon as its connection sees it applied
+            Job* next = job->next;
+            Connection* connection = job->connection;
+            pthread_mutex_lock(&connection->mutex);
+            if (--connection->pending == 0) {
+                pthread_cond_signal(&connection->applied);
+            }
+            pthread_mutex_unlock(&connection->mutex);
+            job = next;
+        }
+    }
+    return nullptr;
+}
+
+bool sendAll(const int socket, const char* data, std::size_t length)
+{
+    while (length > 0) {
+        const ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+// parses the complete commands of buffer into jobs, and with last set
+// whatever is left of it as well. returns the number of bytes consumed,
+// stopping after the first command that closes the connection
+std::size_t parseCommands(const char* buffer, const std::size_t filled,
+                          const bool last, Connection* connection,
+                          DynamicArray<Job>& jobs, bool& closing)
+{
+    const char* cursor = buffer;
+    while (!closing) {
+        Job job;
+        job.connection = connection;
+        job.next = nullptr;
+        char unknownName[MAX_REPLY - 20];
+        const ParseResult result = parseCommand(cursor, buffer + filled, last,
+                                                job.command, unknownName,
+                                                sizeof(unknownName));
+        if (result == ParseResult::INCOMPLETE || result == ParseResult::END) {
+            break;
+        }
+        switch (result) {
+            case ParseResult::OK:
+                job.kind = isMutation(job.command.op) ? JobKind::MUTATION
+                                                      : JobKind::READ;
+                job.replyLength = 0;
+                break;
+            case ParseResult::UNKNOWN_COMMAND:
+                job.kind = JobKind::ERROR;
+                job.replyLength = std::snprintf(job.reply, MAX_REPLY,
+                                                "Unknown command: %s\n",
+                                                unknownName);
+                closing = true;
+                break;
+            default:
+                job.kind = JobKind::ERROR;
+                job.replyLength = std::snprintf(job.reply, MAX_REPLY,
+                                                "Invalid input format\n");
+                closing = true;
+                break;
+        }
+        jobs.pushBack(job);
+    }
+    return cursor - buffer;
+}
+
+void* serveConnection(void* arg)
+{
+    Connection* connection = static_cast<Connection*>(arg);
+    char* readBuffer = new (std::nothrow) char[READ_BUFFER];
+    char* writeBuffer = new (std::nothrow) char[WRITE_BUFFER];
+    DynamicArray<Job> jobs;
+    std::size_t filled = 0;
+    bool closing = readBuffer == nullptr || writeBuffer == nullptr;
+    bool last = false;
+
+    while (!closing && !last) {
+        const ssize_t received = recv(connection->socket, readBuffer + filled,
+                                      READ_BUFFER - filled, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0) {
+            break;
+        }
+        // once the client is done sending, a command cut off at the end is
+        // as malformed as it is for main26a1.cpp at the end of its input
+        last = received == 0;
+        filled += received;
+
+        jobs.truncate(0);
+        std::size_t consumed;
+        try {
+            consumed = parseCommands(readBuffer, filled, last, connection, jobs,
+                                     closing);
+        }
+        catch (const std::bad_alloc&) {
+            break;
+        }
+        if (consumed == 0 && filled == READ_BUFFER) {
+            // a single token longer than the whole buffer
+            static const char message[] = "Invalid input format\n";
+            sendAll(connection->socket, message, sizeof(message) - 1);
+            break;
+        }
+
+        // mutations are queued without waiting, a read waits until every
+        // earlier command of this connection has been applied
+        for (std::size_t i = 0; i < jobs.getSize(); i++) {
+            Job& job = jobs[i];
+            if (job.kind == JobKind::MUTATION) {
+                enqueue(&job);
+            }
+            else if (job.kind == JobKind::READ) {
+                waitApplied(connection);
+                pthread_rwlock_rdlock(&systemLock);
+                job.replyLength = execute(*techSystem, job.command, job.reply,
+                                          MAX_REPLY);
+                pthread_rwlock_unlock(&systemLock);
+            }
+        }
+        waitApplied(connection);
+
+        std::size_t buffered = 0;
+        bool sent = true;
+        for (std::size_t i = 0; i < jobs.getSize() && sent; i++) {
+            const Job& job = jobs[i];
+            if (buffered + job.replyLength > WRITE_BUFFER) {
+                sent = sendAll(connection->socket, writeBuffer, buffered);
+                buffered = 0;
+            }
+            std::memcpy(writeBuffer + buffered, job.reply, job.replyLength);
+            buffered += job.replyLength;
+        }
+        if (!sent || !sendAll(connection->socket, writeBuffer, buffered)) {
+            break;
+        }
+
+        std::memmove(readBuffer, readBuffer + consumed, filled - consumed);
+        filled -= consumed;
+    }
+
+    close(connection->socket);
+    pthread_mutex_destroy(&connection->mutex);
+    pthread_cond_destroy(&connection->applied);
+    delete connection;
+    delete[] readBuffer;
+    delete[] writeBuffer;
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <socket path>\n", argv[0]);
+        return 1;
+    }
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (std::strlen(argv[1]) >= sizeof(address.sun_path)) {
+        std::fprintf(stderr, "socket path too long\n");
+        return 1;
+    }
+    std::strcpy(address.sun_path, argv[1]);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(argv[1]);
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listener, SOMAXCONN) < 0) {
+        std::perror("server26a1");
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    techSystem = new TechSystem();
+    pthread_t writer;
+    if (pthread_create(&writer, nullptr, &writerLoop, nullptr) != 0) {
+        std::fprintf(stderr, "server26a1: cannot start writer thread\n");
+        return 1;
+    }
+
+    while (true) {
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::perror("server26a1: accept");
+            return 1;
+        }
+        Connection* connection = new (std::nothrow) Connection;
+        if (connection == nullptr) {
+            close(client);
+            continue;
+        }
+        connection->socket = client;
+        connection->pending = 0;
+        pthread_mutex_init(&connection->mutex, nullptr);
+        pthread_cond_init(&connection->applied, nullptr);
+
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+        pthread_t thread;
+        if (pthread_create(&thread, &attributes, &serveConnection, connection) != 0) {
+            close(client);
+            pthread_mutex_destroy(&connection->mutex);
+            pthread_cond_destroy(&connection->applied);
+            delete connection;
+        }
+        pthread_attr_destroy(&attributes);
+    }
+}
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""
+Checks server26a1 against the tests and against main26a1.cpp.
+
+Every tests/test{ID}.in is replayed against a fresh server over one
+connection, while several other connections keep asking getStudentPoints
+about the students of the test, and the replies of the replay are compared
+with tests/test{ID}.out. The replay is sent in random sized pieces by one
+thread while another reads the replies, since the server answers as it goes
+and a client that only reads after sending everything would stall both sides
+on a large test. A few inputs that split, join or cut off commands are then
+sent to a server and to the reference binary, and the replies must agree.
+"""
+import argparse
+import os
+import random
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+TIMEOUT = 60
+READERS = 4
+READ_BATCH = 64
+READ_REPLY = re.compile(r"getStudentPoints: (SUCCESS, -?\d+|FAILURE|INVALID_INPUT)")
+
+# inputs whose replies main26a1.cpp and the server must agree on
+PROTOCOL_CASES = [
+    "addStudent 5 7\n",
+    "addStudent 5x\ngetStudentPoints 5\n",
+    "addStudent 3 getStudentPoints\n3\naddCourse\n 4\n 10 enrollStudent 3 4\n",
+    "addStudent 8\ngetStudentPoints 8",
+    "addStudent 9\n\n\t  \r\nremoveStudent 9   \n",
+    "addStudent +12\ngetStudentPoints 12 foo 1\n",
+]
+
+
+class Server:
+    def __init__(self, executable, directory, name):
+        self.path = os.path.join(directory, name)
+        self.process = subprocess.Popen([executable, self.path])
+        deadline = time.time() + TIMEOUT
+        while not os.path.exists(self.path):
+            if self.process.poll() is not None or time.time() > deadline:
+                raise RuntimeError(f"{executable} did not start")
+            time.sleep(0.01)
+
+    def connect(self):
+        connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        connection.settimeout(TIMEOUT)
+        deadline = time.time() + TIMEOUT
+        while True:
+            try:
+                connection.connect(self.path)
+                return connection
+            except (ConnectionRefusedError, FileNotFoundError):
+                if time.time() > deadline:
+                    raise
+                time.sleep(0.01)
+
+    def stop(self):
+        self.process.kill()
+        self.process.wait()
+
+
+def exchange(connection, data, rng):
+    """
+    Sends data in random sized pieces, closing the sending side at the end,
+    while reading every reply until the server closes the connection.
+    """
+    def send():
+        position = 0
+        try:
+            while position < len(data):
+                size = rng.randint(1, 1 << 14)
+                connection.sendall(data[position:position + size])
+                position += size
+            connection.shutdown(socket.SHUT_WR)
+        except OSError:
+            pass  # the server closed after an error reply
+
+    sender = threading.Thread(target=send)
+    sender.start()
+    received = []
+    while True:
+        chunk = connection.recv(1 << 16)
+        if not chunk:
+            break
+        received.append(chunk)
+    sender.join()
+    connection.close()
+    return b"".join(received).decode()
+
+
+def read_students(connection, ids, done, failures):
+    """
+    Asks about random students of ids until done is set, checking that every
+    query gets one well formed reply.
+    """
+    rng = random.Random(len(ids))
+    buffered = ""
+    while not done.is_set():
+        batch = [rng.choice(ids) for _ in range(READ_BATCH)]
+        connection.sendall("".join(f"getStudentPoints {i}\n" for i in batch).encode())
+        lines = []
+        while len(lines) < READ_BATCH:
+            chunk = connection.recv(1 << 16)
+            if not chunk:
+                failures.append("reader connection closed early")
+                return
+            buffered += chunk.decode()
+            *complete, buffered = buffered.split("\n")
+            lines += complete
+        for line in lines:
+            if not READ_REPLY.fullmatch(line):
+                failures.append(f"reader got {line!r}")
+                return
+    connection.close()
+
+
+def check_test(server_file, directory, tests_dir, test_id):
+    with open(os.path.join(tests_dir, f"test{test_id}.in"), "rb") as f:
+        data = f.read()
+    with open(os.path.join(tests_dir, f"test{test_id}.out")) as f:
+        expected = f.read().strip()
+    ids = [int(m) for m in re.findall(rb"addStudent\s+(-?\d+)", data)] or [1]
+
+    server = Server(server_file, directory, f"test{test_id}.sock")
+    try:
+        done = threading.Event()
+        failures = []
+        readers = [threading.Thread(target=read_students,
+                                    args=(server.connect(), ids, done, failures))
+                   for _ in range(READERS)]
+        for reader in readers:
+            reader.start()
+        replies = exchange(server.connect(), data, random.Random(test_id))
+        done.set()
+        for reader in readers:
+            reader.join()
+    finally:
+        server.stop()
+
+    if replies.strip() != expected:
+        print(f"Test {test_id} Failed: replies do not match expected.")
+        return False
+    if failures:
+        print(f"Test {test_id} Failed: {failures[0]}")
+        return False
+    print(f"Test {test_id} Passed")
+    return True
+
+
+def send_slowly(server_file, directory, data):
+    """
+    Sends data to a fresh server one byte at a time, so that every command
+    arrives cut off somewhere, and returns the replies.
+    """
+    server = Server(server_file, directory, "slow.sock")
+    try:
+        connection = server.connect()
+        for byte in data:
+            connection.sendall(bytes([byte]))
+        return exchange(connection, b"", random.Random(0))
+    finally:
+        server.stop()
+
+
+def check_protocol(server_file, reference_file, directory):
+    passed = True
+    for case in PROTOCOL_CASES:
+        data = case.encode()
+        expected = subprocess.run([reference_file], input=data,
+                                  stdout=subprocess.PIPE,
+                                  timeout=TIMEOUT).stdout.decode()
+        server = Server(server_file, directory, "protocol.sock")
+        try:
+            replies = exchange(server.connect(), data, random.Random(0))
+        finally:
+            server.stop()
+        split = send_slowly(server_file, directory, data)
+        if replies != expected or split != expected:
+            print(f"Protocol {case!r} Failed: got {replies!r} and {split!r},"
+                  f" expected {expected!r}")
+            passed = False
+    if passed:
+        print("Protocol Passed")
+    return passed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check server26a1 against the tests.")
+    parser.add_argument("server", help="Path to server26a1.")
+    parser.add_argument("reference", help="Path to main26a1.cpp built on its own.")
+    parser.add_argument(
+        "--tests_dir",
+        type=str,
+        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tests"),
+        help="Path to the dir with the tests (default: the repo's tests).",
+    )
+    args = parser.parse_args()
+
+    tests = sorted(int(f[len("test"):-len(".in")]) for f in os.listdir(args.tests_dir)
+                   if f.startswith("test") and f.endswith(".in"))
+    all_passed = True
+    with tempfile.TemporaryDirectory() as directory:
+        for test_id in tests:
+            all_passed &= check_test(args.server, directory, args.tests_dir, test_id)
+        all_passed &= check_protocol(args.server, args.reference, directory)
+    return 0 if all_passed else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
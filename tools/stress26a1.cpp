@@ -0,0 +1,55 @@
+// Randomized differential stress of AvlTree, BTree and TechSystem.
+//
+//     stress26a1 [-v] [seed [operations [key range]]]
+//
+// AvlTree is run against std::map twice with the same operations: first
+// with every rotation, swap and rebalance audited (heights, balance factors,
+// parent links and key order) and the whole tree checked after each
+// operation, then unaudited to time each operation. BTree gets the same two
+// passes, its audit checking key order, node fill, leaf depth and node
+// alignment after each operation. TechSystem is bulk loaded and then run
+// against a model of the specification, on the id map backend it was built
+// with: stress26a1_btree runs it on BTree. Prints per operation latency
+// summaries, the full histograms with -v, and the tallest AvlTree seen
+// against the AVL height bound. Exits with 1 on the first disagreement.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Stress.h"
+
+int main(int argc, char* argv[])
+{
+    StressOptions options{1, 200000, 4096, false};
+    int arg = 1;
+    if (arg < argc && std::strcmp(argv[arg], "-v") == 0) {
+        options.histograms = true;
+        arg++;
+    }
+    if (argc - arg > 3) {
+        std::fprintf(stderr, "usage: %s [-v] [seed [operations [key range]]]\n",
+                     argv[0]);
+        return 1;
+    }
+    if (arg < argc) {
+        options.seed = static_cast<unsigned>(std::strtoul(argv[arg++], nullptr, 10));
+    }
+    if (arg < argc) {
+        options.operations = std::strtol(argv[arg++], nullptr, 10);
+    }
+    if (arg < argc) {
+        options.keyRange = static_cast<int>(std::strtol(argv[arg++], nullptr, 10));
+    }
+    if (options.operations < 0 || options.keyRange <= 0) {
+        std::fprintf(stderr, "%s: operations and key range must be positive\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("seed %u\n", options.seed);
+    const bool passed = stressAvlTree(options) && stressBTree(options) &&
+                        stressTechSystem(options);
+    std::printf(passed ? "PASSED\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+// Converts a text command stream, as main26a1.cpp reads it, into the binary
+// log format of BinaryCommand.h.
+//
+//     txt2bin26a1 [input [output]]
+//
+// Input defaults to stdin and output to stdout. Commands are parsed like
+// main26a1.cpp parses them, except that each must fit on one line. Unlike
+// main26a1.cpp, which prints an error and stops, an unknown or malformed
+// command is reported with its line number and fails the conversion.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "BinaryCommand.h"
+
+int main(int argc, char* argv[])
+{
+    if (argc > 3) {
+        std::fprintf(stderr, "usage: %s [input [output]]\n", argv[0]);
+        return 1;
+    }
+    FILE* input = argc > 1 ? std::fopen(argv[1], "r") : stdin;
+    if (input == nullptr) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    FILE* output = argc > 2 ? std::fopen(argv[2], "wb") : stdout;
+    if (output == nullptr) {
+        std::perror(argv[2]);
+        return 1;
+    }
+
+    std::fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), output);
+    char* line = nullptr;
+    std::size_t lineCapacity = 0;
+    long lineNumber = 0;
+    long commands = 0;
+    ssize_t lineLength;
+    while ((lineLength = getline(&line, &lineCapacity, input)) >= 0) {
+        lineNumber++;
+        const char* cursor = line;
+        while (true) {
+            Command command;
+            char unknownName[MAX_REPLY];
+            const ParseResult result = parseCommand(cursor, line + lineLength,
+                                                    true, command, unknownName,
+                                                    sizeof(unknownName));
+            if (result == ParseResult::END) {
+                break;
+            }
+            if (result == ParseResult::UNKNOWN_COMMAND) {
+                std::fprintf(stderr, "line %ld: Unknown command: %s\n",
+                             lineNumber, unknownName);
+                return 1;
+            }
+            if (result != ParseResult::OK) {
+                std::fprintf(stderr, "line %ld: Invalid input format\n",
+                             lineNumber);
+                return 1;
+            }
+            unsigned char record[MAX_RECORD];
+            const unsigned char* end = encodeCommand(record, command);
+            std::fwrite(record, 1, end - record, output);
+            commands++;
+        }
+    }
+    std::free(line);
+
+    if (std::ferror(input) || std::fflush(output) != 0 || std::ferror(output)) {
+        std::fprintf(stderr, "%s: I/O error\n", argv[0]);
+        return 1;
+    }
+    std::fprintf(stderr, "%ld commands\n", commands);
+    return 0;
+}